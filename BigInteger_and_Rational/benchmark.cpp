@@ -0,0 +1,224 @@
+// Benchmarks BigInteger and Rational over operand sizes from 10 digits up.
+//
+//   g++ -std=c++17 -O2 -pthread benchmark.cpp -o benchmark
+//   ./benchmark [--max-digits N] [--min-time SECONDS] [--threads N]
+//               [--output results.json] [--baseline previous.json] [--tolerance 0.1]
+//
+// With --baseline, every operation that got slower than the tolerance allows
+// is marked and the exit status is 1, so a run against the results of the
+// previous commit can gate an upgrade.
+
+#include "biginteger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+
+static std::atomic<size_t> allocations{0};
+
+void* operator new(size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* pointer = malloc(size ? size : 1)) return pointer;
+	throw std::bad_alloc();
+}
+// GCC sees malloc and free paired with new and delete once these inline.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* pointer) noexcept {
+	free(pointer);
+}
+void operator delete(void* pointer, size_t) noexcept {
+	free(pointer);
+}
+
+struct Result {
+	string op;
+	size_t digits;
+	double ns_per_op;
+	double digits_per_second;
+	double allocations_per_op;
+};
+
+struct Options {
+	size_t max_digits = 10000000;
+	// Reduction runs a quadratic gcd, so it stops earlier by default.
+	size_t max_norm_digits = 10000;
+	double min_time = 0.2;
+	double tolerance = 0.1;
+	string output;
+	string baseline;
+};
+
+// Results are folded in here so the measured work cannot be optimised away.
+static std::atomic<size_t> sink{0};
+
+static void keep(size_t value) {
+	sink.fetch_add(value, std::memory_order_relaxed);
+}
+
+static BigInteger random_number(std::mt19937_64& random, size_t digits) {
+	string text(digits, '0');
+	text[0] = static_cast<char>('1' + random() % 9);
+	for (size_t i = 1; i < digits; ++i) {
+		text[i] = static_cast<char>('0' + random() % 10);
+	}
+	BigInteger result;
+	std::istringstream in(text);
+	in >> result;
+	return result;
+}
+
+template <class Body>
+static Result measure(const string& op, size_t digits, double min_time, Body body) {
+	using Clock = std::chrono::steady_clock;
+	size_t runs = 0;
+	size_t allocated = allocations.load();
+	Clock::time_point start = Clock::now();
+	double elapsed = 0;
+	do {
+		body();
+		++runs;
+		elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	} while (elapsed < min_time);
+	double ns = elapsed * 1e9 / runs;
+	return {op, digits, ns, digits * 1e9 / ns, static_cast<double>(allocations.load() - allocated) / runs};
+}
+
+static vector<Result> run(const Options& options) {
+	std::mt19937_64 random(20240601);
+	vector<Result> results;
+	for (size_t digits = 10; digits <= options.max_digits; digits *= 10) {
+		BigInteger a = random_number(random, digits);
+		BigInteger b = random_number(random, digits);
+		BigInteger wide = random_number(random, 2 * digits);
+		string text = a.toString();
+		double min_time = options.min_time;
+
+		results.push_back(measure("add", digits, min_time, [&] { keep((a + b).charsLength()); }));
+		results.push_back(measure("mul", digits, min_time, [&] { keep((a * b).charsLength()); }));
+		results.push_back(measure("div", digits, min_time, [&] { keep((wide / a).charsLength()); }));
+		results.push_back(measure("mod", digits, min_time, [&] { keep((wide % a).charsLength()); }));
+		results.push_back(measure("toString", digits, min_time, [&] { keep(a.toString().size()); }));
+		results.push_back(measure("operator>>", digits, min_time, [&] {
+			BigInteger x;
+			std::istringstream in(text);
+			in >> x;
+			keep(x.charsLength());
+		}));
+		if (digits <= options.max_norm_digits) {
+			// Both operands share a factor of the same size, so dividing them
+			// leaves Rational::norm a full-size gcd to cancel.
+			BigInteger common = random_number(random, digits);
+			Rational x(a * common), y(b * common);
+			results.push_back(measure("Rational::norm", digits, min_time, [&] { keep((x / y).toString().size()); }));
+		}
+		Rational fraction = Rational(a) / Rational(b + 7);
+		results.push_back(measure("asDecimal", digits, min_time, [&] { keep(fraction.asDecimal(digits).size()); }));
+	}
+	return results;
+}
+
+static void write_json(std::ostream& out, const vector<Result>& results) {
+	out << "{\n  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const Result& r = results[i];
+		out << "    {\"op\": \"" << r.op << "\", \"digits\": " << r.digits << std::setprecision(10)
+			<< ", \"ns_per_op\": " << r.ns_per_op << ", \"digits_per_second\": " << r.digits_per_second
+			<< ", \"allocations_per_op\": " << r.allocations_per_op << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	out << "  ]\n}\n";
+}
+
+// Reads back what write_json produces; nothing more general is needed.
+static std::map<pair<string, size_t>, double> read_baseline(const string& path) {
+	std::ifstream in(path);
+	if (!in) throw std::runtime_error("cannot open " + path);
+	std::stringstream buffer;
+	buffer << in.rdbuf();
+	string json = buffer.str();
+	auto field = [&](size_t from, size_t to, const string& key) {
+		size_t at = json.find("\"" + key + "\":", from);
+		if (at == string::npos || at > to) throw std::runtime_error("malformed baseline " + path);
+		return json.find_first_not_of(" \"", at + key.size() + 3);
+	};
+	std::map<pair<string, size_t>, double> baseline;
+	for (size_t begin = json.find('{', 1); begin != string::npos; begin = json.find('{', begin + 1)) {
+		size_t end = json.find('}', begin);
+		size_t op = field(begin, end, "op");
+		string name = json.substr(op, json.find('"', op) - op);
+		size_t digits = std::strtoull(json.c_str() + field(begin, end, "digits"), nullptr, 10);
+		baseline[{name, digits}] = std::strtod(json.c_str() + field(begin, end, "ns_per_op"), nullptr);
+	}
+	return baseline;
+}
+
+static string human(double ns) {
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(ns < 10 ? 2 : 1);
+	if (ns < 1e3) out << ns << " ns";
+	else if (ns < 1e6) out << ns / 1e3 << " us";
+	else if (ns < 1e9) out << ns / 1e6 << " ms";
+	else out << ns / 1e9 << " s";
+	return out.str();
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if (i + 1 == argc) {
+			std::cerr << "missing value for " << arg << "\n";
+			return 2;
+		}
+		string value = argv[++i];
+		if (arg == "--max-digits") options.max_digits = std::stoull(value);
+		else if (arg == "--max-norm-digits") options.max_norm_digits = std::stoull(value);
+		else if (arg == "--min-time") options.min_time = std::stod(value);
+		else if (arg == "--threads") BigInteger::thread_count = static_cast<unsigned>(std::stoul(value));
+		else if (arg == "--output") options.output = value;
+		else if (arg == "--baseline") options.baseline = value;
+		else if (arg == "--tolerance") options.tolerance = std::stod(value);
+		else {
+			std::cerr << "unknown option " << arg << "\n";
+			return 2;
+		}
+	}
+
+	std::map<pair<string, size_t>, double> baseline;
+	if (!options.baseline.empty()) baseline = read_baseline(options.baseline);
+
+	vector<Result> results = run(options);
+
+	bool regressed = false;
+	std::cout << std::left << std::setw(16) << "op" << std::right << std::setw(10) << "digits" << std::setw(14) << "time/op"
+		<< std::setw(16) << "digits/s" << std::setw(12) << "allocs/op" << (baseline.empty() ? "" : "    vs baseline") << "\n";
+	for (const Result& r : results) {
+		std::cout << std::left << std::setw(16) << r.op << std::right << std::setw(10) << r.digits << std::setw(14) << human(r.ns_per_op)
+			<< std::setw(16) << std::scientific << std::setprecision(3) << r.digits_per_second << std::defaultfloat << std::setw(12)
+			<< std::setprecision(4) << r.allocations_per_op;
+		auto previous = baseline.find({r.op, r.digits});
+		if (previous != baseline.end()) {
+			double ratio = r.ns_per_op / previous->second;
+			std::cout << "    " << std::fixed << std::setprecision(2) << ratio << "x" << std::defaultfloat;
+			if (ratio > 1 + options.tolerance) {
+				std::cout << "  REGRESSION";
+				regressed = true;
+			}
+		}
+		std::cout << "\n";
+	}
+
+	if (!options.output.empty()) {
+		std::ofstream out(options.output);
+		write_json(out, results);
+	}
+	return regressed ? 1 : 0;
+}
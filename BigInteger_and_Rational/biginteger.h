@@ -1,22 +1,515 @@
 #pragma once
 
+#include <atomic>
+#include <cmath>
+#if __cplusplus >= 202002L
+#include <compare>
+#endif
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
+class LimbVector {
+public:
+	static constexpr uint32_t INLINE_CAPACITY = 6;
+	// Growing out of the inline limbs goes to one 32-byte block first.
+	static constexpr uint32_t FIRST_HEAP_CAPACITY = 8;
+
+	LimbVector() {}
+	LimbVector(size_t count, uint32_t value);
+	LimbVector(const uint32_t* first, const uint32_t* last);
+	LimbVector(const LimbVector& other);
+	LimbVector(LimbVector&& other) noexcept;
+	LimbVector& operator=(const LimbVector& other);
+	LimbVector& operator=(LimbVector&& other);
+	~LimbVector();
+
+	size_t size() const { return length; }
+	bool empty() const { return length == 0; }
+	uint32_t* data() { return is_inline() ? local : heap; }
+	const uint32_t* data() const { return is_inline() ? local : heap; }
+	uint32_t* begin() { return data(); }
+	uint32_t* end() { return data() + length; }
+	const uint32_t* begin() const { return data(); }
+	const uint32_t* end() const { return data() + length; }
+	uint32_t& operator[](size_t index) { return data()[index]; }
+	const uint32_t& operator[](size_t index) const { return data()[index]; }
+	uint32_t& front() { return data()[0]; }
+	uint32_t& back() { return data()[length - 1]; }
+	const uint32_t& front() const { return data()[0]; }
+	const uint32_t& back() const { return data()[length - 1]; }
+
+	void reserve(size_t count);
+	void resize(size_t count, uint32_t value = 0);
+	void assign(size_t count, uint32_t value);
+	void assign(const uint32_t* first, const uint32_t* last);
+	void push_back(uint32_t value);
+	void pop_back() { --length; }
+	void clear() { length = 0; }
+	uint32_t* insert(uint32_t* position, size_t count, uint32_t value);
+	uint32_t* insert(uint32_t* position, const uint32_t* first, const uint32_t* last);
+	uint32_t* erase(uint32_t* first, uint32_t* last);
+
+	// Limb vectors constructed on this thread take their heap storage from
+	// the given resource (nullptr means the global heap) for their whole
+	// life, as pmr containers do: assigning or growing keeps the resource,
+	// move construction adopts the source's, and a move assignment between
+	// different resources copies the limbs.
+	static std::pmr::memory_resource* memoryResource() { return current_resource; }
+	static std::pmr::memory_resource* setMemoryResource(std::pmr::memory_resource* resource);
+
+private:
+	static thread_local std::pmr::memory_resource* current_resource;
+
+	uint32_t length = 0;
+	uint32_t capacity = INLINE_CAPACITY;
+	std::pmr::memory_resource* resource = current_resource;
+	union {
+		uint32_t* heap;
+		uint32_t local[INLINE_CAPACITY];
+	};
+
+	bool is_inline() const { return capacity == INLINE_CAPACITY; }
+	void grow(size_t count);
+	void reallocate(size_t count);
+	void release();
+};
+
+bool operator==(const LimbVector& a, const LimbVector& b);
+
+// Numbers constructed while the scope is active allocate from its resource,
+// so they must not outlive it (or a reset() of a LimbArena behind it).
+// Numbers constructed elsewhere keep their own storage even when assigned
+// or grown inside the scope.
+class LimbResourceScope {
+public:
+	explicit LimbResourceScope(std::pmr::memory_resource* resource) : previous(LimbVector::setMemoryResource(resource)) {}
+	~LimbResourceScope() { LimbVector::setMemoryResource(previous); }
+	LimbResourceScope(const LimbResourceScope&) = delete;
+	LimbResourceScope& operator=(const LimbResourceScope&) = delete;
+
+private:
+	std::pmr::memory_resource* previous;
+};
+
+// Bump allocator for batches of short-lived numbers: deallocation only
+// rewinds the most recent block, reset() reclaims everything at once and
+// keeps the chunks for the next batch. Not thread-safe; worker threads of
+// parallel multiplication keep using their own resource.
+class LimbArena : public std::pmr::memory_resource {
+public:
+	explicit LimbArena(size_t chunk_size = size_t(1) << 20, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+	~LimbArena();
+	LimbArena(const LimbArena&) = delete;
+	LimbArena& operator=(const LimbArena&) = delete;
+
+	void reset();
+	size_t used() const;
+
+private:
+	struct Chunk {
+		char* begin;
+		size_t size;
+	};
+	vector<Chunk> chunks;
+	size_t current = 0;
+	size_t used_before = 0;
+	char* cursor = nullptr;
+	char* limit = nullptr;
+	size_t chunk_size;
+	std::pmr::memory_resource* upstream;
+
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+// Adapts a standard allocator, e.g. FastAllocator<char> from
+// List_and_fastallocator/list.cpp, to a memory resource. Requests are made in
+// 32-byte units, the largest size FastAllocator serves from its pool, so the
+// first heap block of every vector (FIRST_HEAP_CAPACITY limbs) comes from
+// the pool and longer ones from new[].
+template <class Allocator>
+class AllocatorResource : public std::pmr::memory_resource {
+public:
+	explicit AllocatorResource(const Allocator& allocator = Allocator()) : units(static_cast<UnitAllocator>(allocator)) {}
+
+private:
+	struct alignas(16) Unit {
+		unsigned char bytes[32];
+	};
+	using UnitAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Unit>;
+	UnitAllocator units;
+
+	void* do_allocate(size_t bytes, size_t) override { return units.allocate((bytes + sizeof(Unit) - 1) / sizeof(Unit)); }
+	void do_deallocate(void* pointer, size_t bytes, size_t) override {
+		units.deallocate(static_cast<Unit*>(pointer), (bytes + sizeof(Unit) - 1) / sizeof(Unit));
+	}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+thread_local std::pmr::memory_resource* LimbVector::current_resource = nullptr;
+
+std::pmr::memory_resource* LimbVector::setMemoryResource(std::pmr::memory_resource* resource) {
+	std::pmr::memory_resource* previous = current_resource;
+	current_resource = resource;
+	return previous;
+}
+
+LimbVector::LimbVector(size_t count, uint32_t value) {
+	assign(count, value);
+}
+LimbVector::LimbVector(const uint32_t* first, const uint32_t* last) {
+	assign(first, last);
+}
+LimbVector::LimbVector(const LimbVector& other) {
+	assign(other.begin(), other.end());
+}
+LimbVector::LimbVector(LimbVector&& other) noexcept : resource(other.resource) {
+	*this = std::move(other);
+}
+LimbVector& LimbVector::operator=(const LimbVector& other) {
+	if (this != &other) assign(other.begin(), other.end());
+	return *this;
+}
+LimbVector& LimbVector::operator=(LimbVector&& other) {
+	if (this == &other) return *this;
+	if (other.is_inline() || other.resource != resource) {
+		assign(other.begin(), other.end());
+		other.length = 0;
+		return *this;
+	}
+	release();
+	heap = other.heap;
+	length = other.length;
+	capacity = other.capacity;
+	other.length = 0;
+	other.capacity = INLINE_CAPACITY;
+	return *this;
+}
+LimbVector::~LimbVector() {
+	release();
+}
+
+void LimbVector::release() {
+	if (!is_inline()) {
+		if (resource) resource->deallocate(heap, capacity * sizeof(uint32_t), alignof(uint32_t));
+		else ::operator delete(heap);
+	}
+	capacity = INLINE_CAPACITY;
+}
+void LimbVector::reallocate(size_t count) {
+	size_t bytes = count * sizeof(uint32_t);
+	uint32_t* buffer = static_cast<uint32_t*>(resource ? resource->allocate(bytes, alignof(uint32_t)) : ::operator new(bytes));
+	memcpy(buffer, data(), length * sizeof(uint32_t));
+	release();
+	heap = buffer;
+	capacity = static_cast<uint32_t>(count);
+}
+void LimbVector::grow(size_t count) {
+	reallocate(max<size_t>(count, is_inline() ? FIRST_HEAP_CAPACITY : 2 * capacity));
+}
+void LimbVector::reserve(size_t count) {
+	if (count > capacity) reallocate(count);
+}
+void LimbVector::resize(size_t count, uint32_t value) {
+	if (count > capacity) grow(count);
+	for (size_t i = length; i < count; ++i) {
+		data()[i] = value;
+	}
+	length = static_cast<uint32_t>(count);
+}
+void LimbVector::assign(size_t count, uint32_t value) {
+	length = 0;
+	resize(count, value);
+}
+void LimbVector::assign(const uint32_t* first, const uint32_t* last) {
+	size_t count = last - first;
+	if (count > capacity) {
+		// A range longer than the capacity cannot lie in this vector.
+		reallocate(count);
+		memcpy(heap, first, count * sizeof(uint32_t));
+		length = static_cast<uint32_t>(count);
+		return;
+	}
+	memmove(data(), first, count * sizeof(uint32_t));
+	length = static_cast<uint32_t>(count);
+}
+void LimbVector::push_back(uint32_t value) {
+	if (length == capacity) grow(length + 1);
+	data()[length++] = value;
+}
+uint32_t* LimbVector::insert(uint32_t* position, size_t count, uint32_t value) {
+	size_t offset = position - data();
+	size_t tail = length - offset;
+	if (length + count > capacity) grow(length + count);
+	uint32_t* start = data() + offset;
+	memmove(start + count, start, tail * sizeof(uint32_t));
+	for (size_t i = 0; i < count; ++i) {
+		start[i] = value;
+	}
+	length += static_cast<uint32_t>(count);
+	return start;
+}
+uint32_t* LimbVector::insert(uint32_t* position, const uint32_t* first, const uint32_t* last) {
+	LimbVector source(first, last);
+	size_t count = source.size();
+	uint32_t* start = insert(position, count, 0);
+	memcpy(start, source.data(), count * sizeof(uint32_t));
+	return start;
+}
+uint32_t* LimbVector::erase(uint32_t* first, uint32_t* last) {
+	memmove(first, last, (end() - last) * sizeof(uint32_t));
+	length -= static_cast<uint32_t>(last - first);
+	return first;
+}
+
+bool operator==(const LimbVector& a, const LimbVector& b) {
+	return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(uint32_t)) == 0;
+}
+
+LimbArena::LimbArena(size_t chunk_size, std::pmr::memory_resource* upstream) : chunk_size(chunk_size), upstream(upstream) {}
+LimbArena::~LimbArena() {
+	for (const Chunk& chunk : chunks) {
+		upstream->deallocate(chunk.begin, chunk.size, alignof(std::max_align_t));
+	}
+}
+void LimbArena::reset() {
+	current = 0;
+	used_before = 0;
+	cursor = chunks.empty() ? nullptr : chunks[0].begin;
+	limit = chunks.empty() ? nullptr : chunks[0].begin + chunks[0].size;
+}
+size_t LimbArena::used() const {
+	return chunks.empty() ? 0 : used_before + (cursor - chunks[current].begin);
+}
+void* LimbArena::do_allocate(size_t bytes, size_t alignment) {
+	auto fits = [&](char* position) {
+		char* aligned = position + (-reinterpret_cast<uintptr_t>(position) & (alignment - 1));
+		return aligned + bytes <= limit ? aligned : nullptr;
+	};
+	char* result = cursor ? fits(cursor) : nullptr;
+	while (!result) {
+		if (!chunks.empty()) used_before += chunks[current].size;
+		if (chunks.empty() || current + 1 == chunks.size()) {
+			size_t size = max(chunk_size, bytes + alignment);
+			chunks.push_back({static_cast<char*>(upstream->allocate(size, alignof(std::max_align_t))), size});
+			current = chunks.size() - 1;
+		}
+		else {
+			++current;
+		}
+		limit = chunks[current].begin + chunks[current].size;
+		result = fits(chunks[current].begin);
+	}
+	cursor = result + bytes;
+	return result;
+}
+void LimbArena::do_deallocate(void* pointer, size_t bytes, size_t) {
+	if (static_cast<char*>(pointer) + bytes == cursor) cursor = static_cast<char*>(pointer);
+}
+
+// Persistent workers behind BigInteger::parallel_for. They start on first
+// use and live until exit, so forking a job costs a queue push rather than
+// a thread. A thread waiting for its jobs runs queued ones meanwhile, which
+// keeps nested forks from deadlocking however few workers there are.
+class WorkerPool {
+public:
+	static WorkerPool& instance();
+	~WorkerPool();
+
+	// Runs jobs[0] on the calling thread and the rest on up to `workers`
+	// pool threads; rethrows the first exception once every job is done.
+	void run(vector<std::function<void()>>& jobs, unsigned workers);
+
+private:
+	struct Job {
+		std::function<void()>* body;
+		size_t* remaining;
+		std::exception_ptr* error;
+	};
+
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::condition_variable finished;
+	std::deque<Job> queue;
+	vector<std::thread> threads;
+	bool stopping = false;
+
+	WorkerPool() = default;
+	void work();
+	void execute(const Job& job, std::unique_lock<std::mutex>& lock);
+};
+
+WorkerPool& WorkerPool::instance() {
+	static WorkerPool pool;
+	return pool;
+}
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	ready.notify_all();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+void WorkerPool::run(vector<std::function<void()>>& jobs, unsigned workers) {
+	size_t remaining = jobs.size() - 1;
+	std::exception_ptr error;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (threads.size() < workers) {
+		threads.emplace_back([this] { work(); });
+	}
+	for (size_t i = 1; i < jobs.size(); ++i) {
+		queue.push_back({&jobs[i], &remaining, &error});
+	}
+	lock.unlock();
+	ready.notify_all();
+	std::exception_ptr own;
+	try {
+		jobs[0]();
+	}
+	catch (...) {
+		own = std::current_exception();
+	}
+	lock.lock();
+	while (remaining > 0) {
+		if (queue.empty()) {
+			finished.wait(lock);
+			continue;
+		}
+		Job job = queue.front();
+		queue.pop_front();
+		execute(job, lock);
+	}
+	lock.unlock();
+	if (own) std::rethrow_exception(own);
+	if (error) std::rethrow_exception(error);
+}
+void WorkerPool::work() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		ready.wait(lock, [this] { return stopping || !queue.empty(); });
+		if (queue.empty()) return;
+		Job job = queue.front();
+		queue.pop_front();
+		execute(job, lock);
+	}
+}
+void WorkerPool::execute(const Job& job, std::unique_lock<std::mutex>& lock) {
+	lock.unlock();
+	std::exception_ptr caught;
+	try {
+		(*job.body)();
+	}
+	catch (...) {
+		caught = std::current_exception();
+	}
+	lock.lock();
+	if (caught && !*job.error) *job.error = caught;
+	if (--*job.remaining == 0) finished.notify_all();
+}
+
+class BigInteger;
+template <size_t Limbs>
+struct BigIntegerLiteral;
+template <size_t Bits>
+class FixedInteger;
+
+struct BigIntegerProduct {
+	const BigInteger* left;
+	const BigInteger* right;
+	bool negative;
+};
+
+template <size_t N>
+struct BigIntegerProductSum {
+	BigIntegerProduct terms[N];
+};
+
 class BigInteger {
 public:
+	static constexpr uint32_t BASE = 1000000000;
+	static constexpr size_t BASE_DIGITS = 9;
+
+	static size_t karatsuba_threshold;
+	static size_t toom3_threshold;
+	static size_t ntt_threshold;
+	static size_t newton_threshold;
+	static unsigned thread_count;
+	static size_t parallel_threshold;
+
 	BigInteger();
 	BigInteger(int x);
+	BigInteger(const BigInteger& x) = default;
+	BigInteger(BigInteger&& x) = default;
+	BigInteger(const BigIntegerProduct& x);
+	template <size_t N>
+	BigInteger(const BigIntegerProductSum<N>& x);
 	~BigInteger() {};
 
+	BigInteger& operator=(const BigInteger& x) = default;
+	BigInteger& operator=(BigInteger&& x) = default;
+	BigInteger& operator=(const BigIntegerProduct& x);
+	template <size_t N>
+	BigInteger& operator=(const BigIntegerProductSum<N>& x);
+
 	BigInteger& operator+=(const BigInteger& x);
 	BigInteger& operator-=(const BigInteger& x);
 	BigInteger& operator*=(const BigInteger& x);
 	BigInteger& operator/=(const BigInteger& x);
 	BigInteger& operator%=(const BigInteger& x);
+	BigInteger& operator+=(const BigIntegerProduct& x);
+	BigInteger& operator-=(const BigIntegerProduct& x);
+	template <size_t N>
+	BigInteger& operator+=(const BigIntegerProductSum<N>& x);
+	template <size_t N>
+	BigInteger& operator-=(const BigIntegerProductSum<N>& x);
+	template <class T, class = std::enable_if_t<std::is_integral<T>::value>>
+	BigInteger& operator+=(T x);
+	template <class T, class = std::enable_if_t<std::is_integral<T>::value>>
+	BigInteger& operator-=(T x);
+	template <class T, class = std::enable_if_t<std::is_integral<T>::value>>
+	BigInteger& operator*=(T x);
+	template <class T, class = std::enable_if_t<std::is_integral<T>::value>>
+	BigInteger& operator/=(T x);
+	template <class T, class = std::enable_if_t<std::is_integral<T>::value>>
+	BigInteger& operator%=(T x);
+
+	BigInteger& addmul(const BigInteger& a, const BigInteger& b);
+	BigInteger& submul(const BigInteger& a, const BigInteger& b);
+	BigInteger& add_n(const BigInteger* terms, size_t count);
+	BigInteger& sub_n(const BigInteger* terms, size_t count);
 
 	BigInteger operator-() const;
 
@@ -26,22 +519,134 @@ public:
 	BigInteger operator--(int);
 
 	string toString() const;
-	explicit operator bool();
+	size_t charsLength() const;
+	char* toChars(char* buffer) const;
+	explicit operator bool() const;
+
+	static BigInteger powerOfTen(size_t exponent);
 
 private:
-	vector<short> numbers;
+	LimbVector numbers;
 	bool sign;
 
 	void norm();
+	void assign_chars(const char* begin, const char* end);
 
 	BigInteger& increase(const BigInteger&);
 	BigInteger& decrease(const BigInteger&);
+	BigInteger& add_product(const BigInteger& a, const BigInteger& b, bool negative);
+	BigInteger& accumulate(const BigIntegerProduct* terms, size_t count, bool negative);
+	BigInteger& assign_products(const BigIntegerProduct* terms, size_t count);
+	bool is_referenced(const BigIntegerProduct* terms, size_t count) const;
+	BigInteger& accumulate_terms(const BigInteger* terms, size_t count, bool negative);
+	uint32_t divide_small(uint32_t x);
+
+	template <class T>
+	static bool word_negative(T x);
+	template <class T>
+	static uint64_t word_magnitude(T x);
+	BigInteger& add_word(uint64_t magnitude, bool negative);
+	BigInteger& multiply_word(uint64_t magnitude, bool negative);
+	uint64_t divide_word(uint64_t magnitude);
+	int compare_word(uint64_t magnitude, bool negative) const;
+	BigInteger& multiply_power_of_ten(size_t exponent);
+
+	static constexpr uint32_t POWERS_OF_TEN[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+	static size_t limb_digits(uint32_t limb);
+
+	static constexpr size_t WORD_LIMBS = 2;
+	static constexpr size_t NATIVE_LIMBS = 4;
+	int64_t to_word() const;
+	unsigned __int128 to_native() const;
+	void assign_native(unsigned __int128 value);
+
+	static BigInteger from_limbs(const uint32_t* begin, const uint32_t* end);
+	static void trim(LimbVector& x);
+	static int compare_limbs(const LimbVector& a, const LimbVector& b);
+	static LimbVector multiply_small(const LimbVector& a, uint32_t x);
+	static uint32_t add_limbs(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t carry);
+	static uint32_t subtract_limbs(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t borrow);
+	static uint32_t add_limbs_scalar(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t carry);
+	static uint32_t subtract_limbs_scalar(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t borrow);
+#if defined(__GNUC__) && defined(__x86_64__)
+	static uint32_t add_limbs_avx2(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t carry);
+	static uint32_t subtract_limbs_avx2(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t borrow);
+	static uint32_t add_limbs_avx512(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t carry);
+	static uint32_t subtract_limbs_avx512(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t borrow);
+#endif
+	static void propagate_carry(LimbVector& x, size_t from, uint32_t carry);
+	static void propagate_borrow(LimbVector& x, size_t from, uint32_t borrow);
+	static void add_shifted(LimbVector& result, const LimbVector& x, size_t shift);
+	static void subtract_abs(LimbVector& result, const LimbVector& x);
+	static LimbVector multiply_abs(const LimbVector& a, const LimbVector& b);
+	static LimbVector square_abs(const LimbVector& a);
+	static LimbVector multiply_schoolbook(const LimbVector& a, const LimbVector& b);
+	static void multiply_accumulate(LimbVector& result, const LimbVector& a, const LimbVector& b);
+	static LimbVector square_schoolbook(const LimbVector& a);
+	static LimbVector multiply_karatsuba(const LimbVector& a, const LimbVector& b);
+	static LimbVector square_karatsuba(const LimbVector& a);
+	static LimbVector multiply_toom3(const LimbVector& a, const LimbVector& b);
+	static LimbVector multiply_ntt(const LimbVector& a, const LimbVector& b);
+
+	static constexpr size_t MAX_NTT_LENGTH = size_t(1) << 23;
+	static std::atomic<unsigned> busy_threads;
+	static unsigned acquire_threads(unsigned wanted);
+	template <class Body>
+	static void parallel_for(size_t count, size_t work, Body body);
+	template <class... Tasks>
+	static void parallel_invoke(size_t work, Tasks... tasks);
+	static uint32_t power_mod(uint64_t x, uint64_t power, uint32_t mod);
+	template <uint32_t mod>
+	static void ntt(vector<uint32_t>& a, bool invert);
+	template <uint32_t mod>
+	static vector<uint32_t> convolution(const LimbVector& a, const LimbVector& b, size_t length);
+
+	static void divide_abs(const LimbVector& a, const LimbVector& b, LimbVector& quotient, LimbVector& remainder);
+	static void divide_knuth(const LimbVector& a, const LimbVector& b, LimbVector& quotient, LimbVector& remainder);
+	static void divide_newton(const LimbVector& a, const LimbVector& b, LimbVector& quotient, LimbVector& remainder);
+	static LimbVector reciprocal(const LimbVector& b);
+	static LimbVector divide_exact_abs(const LimbVector& a, const LimbVector& b);
+
+	static uint64_t gcd_word(uint64_t a, uint64_t b);
+	static LimbVector gcd_abs(LimbVector a, LimbVector b);
+	static void combine(const LimbVector& a, const LimbVector& b, int64_t x, int64_t y, LimbVector& result);
+	static BigInteger root_estimate(const BigInteger& x, unsigned degree);
+
+	friend BigInteger operator*(const BigInteger& a, const BigInteger& b);
+	friend BigInteger operator-(const BigInteger& a, BigInteger&& b);
+	friend pair<BigInteger, BigInteger> divmod(const BigInteger& a, const BigInteger& b);
+	friend BigInteger divexact(const BigInteger& a, const BigInteger& b);
+	friend BigInteger gcd(const BigInteger& a, const BigInteger& b);
+	friend BigInteger pow(const BigInteger& base, uint64_t exponent);
+	friend BigInteger isqrt(const BigInteger& x);
+	friend BigInteger iroot(const BigInteger& x, unsigned degree);
+	template <class Iterator>
+	friend BigInteger product(Iterator first, Iterator last);
 
 	friend bool operator==(const BigInteger& a, const BigInteger& b);
 
 	friend bool operator<(const BigInteger& a, const BigInteger& b);
+	template <class T>
+	friend std::enable_if_t<std::is_integral<T>::value, bool> operator==(const BigInteger& a, T b);
+	template <class T>
+	friend std::enable_if_t<std::is_integral<T>::value, bool> operator<(const BigInteger& a, T b);
+	template <class T>
+	friend std::enable_if_t<std::is_integral<T>::value, bool> operator<(T a, const BigInteger& b);
+#if __cplusplus >= 202002L
+	friend std::strong_ordering operator<=>(const BigInteger& a, const BigInteger& b);
+	template <class T>
+	friend std::enable_if_t<std::is_integral<T>::value, std::strong_ordering> operator<=>(const BigInteger& a, T b);
+#endif
 	friend istream& operator>>(std::istream& in, BigInteger& x);
-	bool is_equal_no_sign(const BigInteger& x);
+	friend class Rational;
+	friend class Modulus;
+	friend struct BinaryFormat;
+	template <size_t Limbs>
+	friend struct BigIntegerLiteral;
+	template <size_t Bits>
+	friend class FixedInteger;
+	static int compare_abs(const BigInteger& a, const BigInteger& b);
+	static int compare(const BigInteger& a, const BigInteger& b);
 };
 
 BigInteger operator+(const BigInteger& a, const BigInteger& b);
@@ -50,14 +655,88 @@ BigInteger operator*(const BigInteger& a, const BigInteger& b);
 BigInteger operator/(const BigInteger& a, const BigInteger& b);
 BigInteger operator%(const BigInteger& a, const BigInteger& b);
 
+BigInteger operator+(BigInteger&& a, const BigInteger& b);
+BigInteger operator+(const BigInteger& a, BigInteger&& b);
+BigInteger operator+(BigInteger&& a, BigInteger&& b);
+BigInteger operator-(BigInteger&& a, const BigInteger& b);
+BigInteger operator-(const BigInteger& a, BigInteger&& b);
+BigInteger operator-(BigInteger&& a, BigInteger&& b);
+BigInteger operator*(BigInteger&& a, const BigInteger& b);
+BigInteger operator*(const BigInteger& a, BigInteger&& b);
+BigInteger operator*(BigInteger&& a, BigInteger&& b);
+BigInteger operator/(BigInteger&& a, const BigInteger& b);
+BigInteger operator%(BigInteger&& a, const BigInteger& b);
+
+BigIntegerProduct mul(const BigInteger& a, const BigInteger& b);
+BigIntegerProduct operator-(const BigIntegerProduct& x);
+BigIntegerProductSum<2> operator+(const BigIntegerProduct& a, const BigIntegerProduct& b);
+BigIntegerProductSum<2> operator-(const BigIntegerProduct& a, const BigIntegerProduct& b);
+template <size_t N>
+BigIntegerProductSum<N + 1> operator+(const BigIntegerProductSum<N>& a, const BigIntegerProduct& b);
+template <size_t N>
+BigIntegerProductSum<N + 1> operator-(const BigIntegerProductSum<N>& a, const BigIntegerProduct& b);
+
+pair<BigInteger, BigInteger> divmod(const BigInteger& a, const BigInteger& b);
+BigInteger divexact(const BigInteger& a, const BigInteger& b);
+BigInteger gcd(const BigInteger& a, const BigInteger& b);
+BigInteger pow(const BigInteger& base, uint64_t exponent);
+BigInteger isqrt(const BigInteger& x);
+BigInteger iroot(const BigInteger& x, unsigned degree);
+template <class Iterator>
+BigInteger product(Iterator first, Iterator last);
+
 bool operator>(const BigInteger& a, const BigInteger& b);
 bool operator!=(const BigInteger& a, const BigInteger& b);
 bool operator<=(const BigInteger& a, const BigInteger& b);
 bool operator>=(const BigInteger& a, const BigInteger& b);
+#if __cplusplus >= 202002L
+std::strong_ordering operator<=>(const BigInteger& a, const BigInteger& b);
+#endif
+
+template <class T>
+using IfWord = std::enable_if_t<std::is_integral<T>::value, BigInteger>;
+template <class T>
+using IfWordTest = std::enable_if_t<std::is_integral<T>::value, bool>;
+
+template <class T> IfWord<T> operator+(const BigInteger& a, T b);
+template <class T> IfWord<T> operator-(const BigInteger& a, T b);
+template <class T> IfWord<T> operator*(const BigInteger& a, T b);
+template <class T> IfWord<T> operator/(const BigInteger& a, T b);
+template <class T> IfWord<T> operator%(const BigInteger& a, T b);
+template <class T> IfWord<T> operator+(BigInteger&& a, T b);
+template <class T> IfWord<T> operator-(BigInteger&& a, T b);
+template <class T> IfWord<T> operator*(BigInteger&& a, T b);
+template <class T> IfWord<T> operator/(BigInteger&& a, T b);
+template <class T> IfWord<T> operator%(BigInteger&& a, T b);
+
+template <class T> IfWordTest<T> operator==(const BigInteger& a, T b);
+template <class T> IfWordTest<T> operator!=(const BigInteger& a, T b);
+template <class T> IfWordTest<T> operator<(const BigInteger& a, T b);
+template <class T> IfWordTest<T> operator>(const BigInteger& a, T b);
+template <class T> IfWordTest<T> operator<=(const BigInteger& a, T b);
+template <class T> IfWordTest<T> operator>=(const BigInteger& a, T b);
+template <class T> IfWordTest<T> operator==(T a, const BigInteger& b);
+template <class T> IfWordTest<T> operator!=(T a, const BigInteger& b);
+template <class T> IfWordTest<T> operator<(T a, const BigInteger& b);
+template <class T> IfWordTest<T> operator>(T a, const BigInteger& b);
+template <class T> IfWordTest<T> operator<=(T a, const BigInteger& b);
+template <class T> IfWordTest<T> operator>=(T a, const BigInteger& b);
+#if __cplusplus >= 202002L
+template <class T>
+std::enable_if_t<std::is_integral<T>::value, std::strong_ordering> operator<=>(const BigInteger& a, T b);
+#endif
 
 std::ostream& operator<<(std::ostream& out, const BigInteger& x);
 std::istream& operator>>(std::istream& in, BigInteger& x);
 
+size_t BigInteger::karatsuba_threshold = 48;
+size_t BigInteger::toom3_threshold = 256;
+size_t BigInteger::ntt_threshold = 600;
+size_t BigInteger::newton_threshold = 1000;
+unsigned BigInteger::thread_count = 1;
+size_t BigInteger::parallel_threshold = 2000;
+std::atomic<unsigned> BigInteger::busy_threads(0);
+
 void BigInteger::norm() {
 	while (numbers.size() > 1 && numbers.back() == 0) {
 		numbers.pop_back();
@@ -66,86 +745,75 @@ void BigInteger::norm() {
 	if (numbers.size() == 1 && numbers.front() == 0) sign = true;
 
 }
-BigInteger::BigInteger() {
-	numbers.push_back(1);
-	numbers.push_back(0);
-	sign = true;
-}
+BigInteger::BigInteger() : BigInteger(0) {}
 BigInteger::BigInteger(int x) {
 	sign = x >= 0;
-	if (!sign) x *= -1;
-	while (x > 0) {
-		numbers.push_back(x % 10);
-		x /= 10;
+	long long value = x;
+	if (!sign) value = -value;
+	while (value > 0) {
+		numbers.push_back(static_cast<uint32_t>(value % BASE));
+		value /= BASE;
 	}
 	norm();
 }
-bool BigInteger::is_equal_no_sign(const BigInteger& x) {
-	if (numbers.size() != x.numbers.size()) {
-		return numbers.size() < x.numbers.size();
-	}
-	for (size_t i = numbers.size(); i > 0;) {
-		--i;
-		if (numbers[i] < x.numbers[i]) return true;
-		if (numbers[i] > x.numbers[i]) return false;
-	}
-	return true;
+int BigInteger::compare_abs(const BigInteger& a, const BigInteger& b) {
+	return compare_limbs(a.numbers, b.numbers);
+}
+int BigInteger::compare(const BigInteger& a, const BigInteger& b) {
+	if (a.sign != b.sign) return a.sign ? 1 : -1;
+	int cmp = compare_abs(a, b);
+	return a.sign ? cmp : -cmp;
 }
 BigInteger& BigInteger::increase(const BigInteger& x) {
-	size_t min_lenght = numbers.size() < x.numbers.size() ? numbers.size() : x.numbers.size();
-	size_t i;
-	for (i = 0; i < min_lenght; ++i) {
-		numbers[i] += x.numbers[i];
-	}
-	for (i = min_lenght; i < x.numbers.size(); ++i) {
-		numbers.push_back(x.numbers[i]);
-	}
-	for (i = 0; i < numbers.size(); ++i) {
-		if (numbers[i] > 9) {
-			numbers[i] -= 10;
-			if (i < numbers.size() - 1) {
-				++numbers[i + 1];
-			}
-			else {
-				numbers.push_back(1);
-			}
-		}
+	if (numbers.size() < x.numbers.size()) {
+		numbers.resize(x.numbers.size(), 0);
 	}
+	size_t count = x.numbers.size();
+	propagate_carry(numbers, count, add_limbs(numbers.data(), numbers.data(), x.numbers.data(), count, 0));
 	norm();
 	return *this;
 }
 BigInteger& BigInteger::decrease(const BigInteger& x) {
-	const BigInteger* a = this;
-	const BigInteger* b = &x;
-
-	if (is_equal_no_sign(x)) {
+	if (compare_abs(*this, x) < 0) {
 		sign ^= true;
-		swap(a, b);
+		numbers.resize(x.numbers.size(), 0);
+		subtract_limbs(numbers.data(), x.numbers.data(), numbers.data(), numbers.size(), 0);
 	}
-
-	long long sum = 0;
-	for (size_t i = 0; i < a->numbers.size(); ++i) {
-		sum += a->numbers[i];
-		if (i < b->numbers.size()) {
-			sum -= b->numbers[i];
-		}
-		if (a == this && i >= b->numbers.size()) {
-			if (sum == numbers[i])
-				break;
-		}
-		long long next_sum = 0;
-		if (sum < 0) {
-			next_sum = (sum - 9) / 10;
-			sum += 10;
-		}
-		if (numbers.size() <= i) numbers.push_back(0);
-		numbers[i] = static_cast<unsigned int>(sum % 10);
-		sum = next_sum;
+	else {
+		size_t count = x.numbers.size();
+		propagate_borrow(numbers, count, subtract_limbs(numbers.data(), numbers.data(), x.numbers.data(), count, 0));
 	}
-
 	norm();
 	return *this;
 }
+BigInteger& BigInteger::add_n(const BigInteger* terms, size_t count) {
+	return accumulate_terms(terms, count, false);
+}
+BigInteger& BigInteger::sub_n(const BigInteger* terms, size_t count) {
+	return accumulate_terms(terms, count, true);
+}
+// Sums positive and negative terms into two raw accumulators and touches
+// *this once, so no per-term sign handling or normalisation.
+BigInteger& BigInteger::accumulate_terms(const BigInteger* terms, size_t count, bool negative) {
+	size_t length = 0;
+	for (size_t i = 0; i < count; ++i) {
+		length = max(length, terms[i].numbers.size());
+	}
+	BigInteger parts[2];
+	for (size_t k = 0; k < 2; ++k) {
+		parts[k].numbers.reserve(length + 1);
+	}
+	for (size_t i = 0; i < count; ++i) {
+		LimbVector& sum = parts[terms[i].sign == negative].numbers;
+		const LimbVector& x = terms[i].numbers;
+		if (sum.size() < x.size()) sum.resize(x.size(), 0);
+		propagate_carry(sum, x.size(), add_limbs(sum.data(), sum.data(), x.data(), x.size(), 0));
+	}
+	parts[0].norm();
+	parts[1].norm();
+	*this += parts[0];
+	return *this -= parts[1];
+}
 
 BigInteger BigInteger::operator-() const {
 	BigInteger neg_x = *this;
@@ -154,62 +822,1001 @@ BigInteger BigInteger::operator-() const {
 	return neg_x;
 }
 BigInteger& BigInteger::operator+=(const BigInteger& x) {
+	if (numbers.size() <= WORD_LIMBS && x.numbers.size() <= WORD_LIMBS) {
+		int64_t value = to_word() + x.to_word();
+		sign = value >= 0;
+		assign_native(sign ? value : -value);
+		return *this;
+	}
 	return (sign == x.sign) ? increase(x) : decrease(x);
 }
 BigInteger& BigInteger::operator-=(const BigInteger& x) {
+	if (numbers.size() <= WORD_LIMBS && x.numbers.size() <= WORD_LIMBS) {
+		int64_t value = to_word() - x.to_word();
+		sign = value >= 0;
+		assign_native(sign ? value : -value);
+		return *this;
+	}
 	return (sign == x.sign) ? decrease(x) : increase(x);
 }
 BigInteger& BigInteger::operator*=(const BigInteger& x) {
-	vector<short> result;
-	size_t length = 1 + numbers.size() + x.numbers.size();
 	sign ^= !x.sign;
-	result.resize(length);
-	for (size_t i = 0; i < numbers.size(); i++) {
-		for (size_t j = 0; j < x.numbers.size(); j++) {
-			result[i + j] += numbers[i] * x.numbers[j];
-		}
-	}
-	for (size_t i = 0; i < length - 1; i++) {
-		result[i + 1] += result[i] / 10;
-		result[i] %= 10;
+	if (numbers.size() + x.numbers.size() <= NATIVE_LIMBS) {
+		assign_native(to_native() * x.to_native());
+		norm();
+		return *this;
 	}
-
-	numbers = result;
+	numbers = (&x == this) ? square_abs(numbers) : multiply_abs(numbers, x.numbers);
 	norm();
 	return *this;
 }
-BigInteger& BigInteger::operator/=(const BigInteger& x) {
-	vector<short> result;
-	BigInteger tmp = 0;
+unsigned __int128 BigInteger::to_native() const {
+	unsigned __int128 value = 0;
 	for (size_t i = numbers.size(); i > 0;) {
 		--i;
-		tmp = tmp * 10 + numbers[i];
-		short left = 0, right = 11;
-		while (right - left > 1) {
-			short middle = (left + right) / 2;
-			if ((x * middle).is_equal_no_sign(tmp)) {
-				left = middle;
+		value = value * BASE + numbers[i];
+	}
+	return value;
+}
+int64_t BigInteger::to_word() const {
+	int64_t value = numbers[0];
+	if (numbers.size() > 1) value += static_cast<int64_t>(numbers[1]) * BASE;
+	return sign ? value : -value;
+}
+void BigInteger::assign_native(unsigned __int128 value) {
+	const uint64_t word_base = static_cast<uint64_t>(BASE) * BASE;
+	uint64_t low = static_cast<uint64_t>(value);
+	uint64_t high = 0;
+	if (value >> 64) {
+		high = static_cast<uint64_t>(value / word_base);
+		low = static_cast<uint64_t>(value % word_base);
+	}
+	else if (low >= word_base) {
+		high = low / word_base;
+		low %= word_base;
+	}
+	numbers.resize(NATIVE_LIMBS);
+	numbers[0] = static_cast<uint32_t>(low % BASE);
+	numbers[1] = static_cast<uint32_t>(low / BASE);
+	numbers[2] = static_cast<uint32_t>(high % BASE);
+	numbers[3] = static_cast<uint32_t>(high / BASE);
+	norm();
+}
+uint32_t BigInteger::divide_small(uint32_t x) {
+	uint64_t rest = 0;
+	for (size_t i = numbers.size(); i > 0;) {
+		--i;
+		uint64_t cur = numbers[i] + rest * BASE;
+		numbers[i] = static_cast<uint32_t>(cur / x);
+		rest = cur % x;
+	}
+	norm();
+	return static_cast<uint32_t>(rest);
+}
+
+BigInteger BigInteger::from_limbs(const uint32_t* begin, const uint32_t* end) {
+	BigInteger result;
+	result.numbers.assign(begin, end);
+	result.norm();
+	return result;
+}
+void BigInteger::trim(LimbVector& x) {
+	while (!x.empty() && x.back() == 0) {
+		x.pop_back();
+	}
+}
+int BigInteger::compare_limbs(const LimbVector& a, const LimbVector& b) {
+	if (a.size() != b.size()) {
+		return a.size() < b.size() ? -1 : 1;
+	}
+	for (size_t i = a.size(); i > 0;) {
+		--i;
+		if (a[i] < b[i]) return -1;
+		if (a[i] > b[i]) return 1;
+	}
+	return 0;
+}
+LimbVector BigInteger::multiply_small(const LimbVector& a, uint32_t x) {
+	LimbVector result(a.size() + 1, 0);
+	uint64_t carry = 0;
+	for (size_t i = 0; i < a.size(); ++i) {
+		uint64_t cur = static_cast<uint64_t>(a[i]) * x + carry;
+		result[i] = static_cast<uint32_t>(cur % BASE);
+		carry = cur / BASE;
+	}
+	result[a.size()] = static_cast<uint32_t>(carry);
+	trim(result);
+	return result;
+}
+uint32_t BigInteger::add_limbs_scalar(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t carry) {
+	for (size_t i = 0; i < count; ++i) {
+		uint32_t sum = a[i] + b[i] + carry;
+		carry = sum >= BASE;
+		result[i] = carry ? sum - BASE : sum;
+	}
+	return carry;
+}
+uint32_t BigInteger::subtract_limbs_scalar(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t borrow) {
+	for (size_t i = 0; i < count; ++i) {
+		uint32_t diff = a[i] - b[i] - borrow;
+		borrow = a[i] < b[i] + borrow;
+		result[i] = borrow ? diff + BASE : diff;
+	}
+	return borrow;
+}
+#if defined(__GNUC__) && defined(__x86_64__)
+// The vector kernels resolve carries across lanes with a lookahead on lane
+// masks: a lane generates a carry when its sum is at least BASE and passes
+// one through when it equals BASE - 1, so adding the shifted generate mask
+// to the propagate mask ripples every carry to where it lands.
+__attribute__((target("avx2")))
+uint32_t BigInteger::add_limbs_avx2(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t carry) {
+	const __m256i base = _mm256_set1_epi32(BASE);
+	const __m256i top = _mm256_set1_epi32(BASE - 1);
+	const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i sum = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+		uint32_t generate = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(sum, top)));
+		uint32_t propagate = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(sum, top)));
+		uint32_t carries = (((generate << 1) | carry) + propagate) ^ propagate;
+		carry = (carries >> 8) & 1;
+		__m256i incoming = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(carries), lanes), lanes);
+		sum = _mm256_sub_epi32(sum, incoming);
+		sum = _mm256_sub_epi32(sum, _mm256_and_si256(_mm256_cmpgt_epi32(sum, top), base));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(result + i), sum);
+	}
+	return add_limbs_scalar(result + i, a + i, b + i, count - i, carry);
+}
+__attribute__((target("avx2")))
+uint32_t BigInteger::subtract_limbs_avx2(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t borrow) {
+	const __m256i base = _mm256_set1_epi32(BASE);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i diff = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+		uint32_t generate = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(zero, diff)));
+		uint32_t propagate = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(diff, zero)));
+		uint32_t borrows = (((generate << 1) | borrow) + propagate) ^ propagate;
+		borrow = (borrows >> 8) & 1;
+		__m256i incoming = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(borrows), lanes), lanes);
+		diff = _mm256_add_epi32(diff, incoming);
+		diff = _mm256_add_epi32(diff, _mm256_and_si256(_mm256_cmpgt_epi32(zero, diff), base));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(result + i), diff);
+	}
+	return subtract_limbs_scalar(result + i, a + i, b + i, count - i, borrow);
+}
+__attribute__((target("avx512f")))
+uint32_t BigInteger::add_limbs_avx512(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t carry) {
+	const __m512i base = _mm512_set1_epi32(BASE);
+	const __m512i top = _mm512_set1_epi32(BASE - 1);
+	const __m512i one = _mm512_set1_epi32(1);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m512i sum = _mm512_add_epi32(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+		uint32_t generate = _mm512_cmpgt_epu32_mask(sum, top);
+		uint32_t propagate = _mm512_cmpeq_epu32_mask(sum, top);
+		uint32_t carries = (((generate << 1) | carry) + propagate) ^ propagate;
+		carry = (carries >> 16) & 1;
+		sum = _mm512_mask_add_epi32(sum, static_cast<__mmask16>(carries), sum, one);
+		sum = _mm512_mask_sub_epi32(sum, _mm512_cmpgt_epu32_mask(sum, top), sum, base);
+		_mm512_storeu_si512(result + i, sum);
+	}
+	return add_limbs_scalar(result + i, a + i, b + i, count - i, carry);
+}
+__attribute__((target("avx512f")))
+uint32_t BigInteger::subtract_limbs_avx512(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t borrow) {
+	const __m512i base = _mm512_set1_epi32(BASE);
+	const __m512i zero = _mm512_setzero_si512();
+	const __m512i one = _mm512_set1_epi32(1);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m512i diff = _mm512_sub_epi32(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+		uint32_t generate = _mm512_cmplt_epi32_mask(diff, zero);
+		uint32_t propagate = _mm512_cmpeq_epi32_mask(diff, zero);
+		uint32_t borrows = (((generate << 1) | borrow) + propagate) ^ propagate;
+		borrow = (borrows >> 16) & 1;
+		diff = _mm512_mask_sub_epi32(diff, static_cast<__mmask16>(borrows), diff, one);
+		diff = _mm512_mask_add_epi32(diff, _mm512_cmplt_epi32_mask(diff, zero), diff, base);
+		_mm512_storeu_si512(result + i, diff);
+	}
+	return subtract_limbs_scalar(result + i, a + i, b + i, count - i, borrow);
+}
+#endif
+uint32_t BigInteger::add_limbs(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t carry) {
+	if (count < 16) return add_limbs_scalar(result, a, b, count, carry);
+#if defined(__GNUC__) && defined(__x86_64__)
+	static const auto kernel = [] {
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f")) return add_limbs_avx512;
+		if (__builtin_cpu_supports("avx2")) return add_limbs_avx2;
+		return add_limbs_scalar;
+	}();
+	return kernel(result, a, b, count, carry);
+#else
+	return add_limbs_scalar(result, a, b, count, carry);
+#endif
+}
+uint32_t BigInteger::subtract_limbs(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t count, uint32_t borrow) {
+	if (count < 16) return subtract_limbs_scalar(result, a, b, count, borrow);
+#if defined(__GNUC__) && defined(__x86_64__)
+	static const auto kernel = [] {
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f")) return subtract_limbs_avx512;
+		if (__builtin_cpu_supports("avx2")) return subtract_limbs_avx2;
+		return subtract_limbs_scalar;
+	}();
+	return kernel(result, a, b, count, borrow);
+#else
+	return subtract_limbs_scalar(result, a, b, count, borrow);
+#endif
+}
+void BigInteger::propagate_carry(LimbVector& x, size_t from, uint32_t carry) {
+	for (size_t i = from; carry && i < x.size(); ++i) {
+		carry = ++x[i] == BASE;
+		if (carry) x[i] = 0;
+	}
+	if (carry) x.push_back(1);
+}
+void BigInteger::propagate_borrow(LimbVector& x, size_t from, uint32_t borrow) {
+	for (size_t i = from; borrow; ++i) {
+		borrow = x[i] == 0;
+		x[i] = borrow ? BASE - 1 : x[i] - 1;
+	}
+}
+void BigInteger::add_shifted(LimbVector& result, const LimbVector& x, size_t shift) {
+	if (result.size() < x.size() + shift) {
+		result.resize(x.size() + shift, 0);
+	}
+	uint32_t* target = result.data() + shift;
+	propagate_carry(result, x.size() + shift, add_limbs(target, target, x.data(), x.size(), 0));
+}
+void BigInteger::subtract_abs(LimbVector& result, const LimbVector& x) {
+	propagate_borrow(result, x.size(), subtract_limbs(result.data(), result.data(), x.data(), x.size(), 0));
+	trim(result);
+}
+
+LimbVector BigInteger::multiply_abs(const LimbVector& a, const LimbVector& b) {
+	size_t min_length = min(a.size(), b.size());
+	size_t max_length = max(a.size(), b.size());
+	if (min_length < karatsuba_threshold) {
+		return multiply_schoolbook(a, b);
+	}
+	if (min_length >= ntt_threshold && a.size() + b.size() <= MAX_NTT_LENGTH) {
+		return multiply_ntt(a, b);
+	}
+	if (min_length >= toom3_threshold && 3 * min_length > 2 * max_length) {
+		return multiply_toom3(a, b);
+	}
+	return multiply_karatsuba(a, b);
+}
+LimbVector BigInteger::square_abs(const LimbVector& a) {
+	if (a.size() < karatsuba_threshold) {
+		return square_schoolbook(a);
+	}
+	if (a.size() >= ntt_threshold && 2 * a.size() <= MAX_NTT_LENGTH) {
+		return multiply_ntt(a, a);
+	}
+	if (a.size() >= toom3_threshold) {
+		return multiply_toom3(a, a);
+	}
+	return square_karatsuba(a);
+}
+LimbVector BigInteger::multiply_schoolbook(const LimbVector& a, const LimbVector& b) {
+	LimbVector result(a.size() + b.size(), 0);
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (a[i] == 0) continue;
+		uint64_t carry = 0;
+		for (size_t j = 0; j < b.size(); ++j) {
+			uint64_t cur = result[i + j] + static_cast<uint64_t>(a[i]) * b[j] + carry;
+			result[i + j] = static_cast<uint32_t>(cur % BASE);
+			carry = cur / BASE;
+		}
+		result[i + b.size()] = static_cast<uint32_t>(carry);
+	}
+	trim(result);
+	return result;
+}
+void BigInteger::multiply_accumulate(LimbVector& result, const LimbVector& a, const LimbVector& b) {
+	result.resize(max(result.size(), a.size() + b.size()) + 1, 0);
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (a[i] == 0) continue;
+		uint64_t carry = 0;
+		for (size_t j = 0; j < b.size(); ++j) {
+			uint64_t cur = result[i + j] + static_cast<uint64_t>(a[i]) * b[j] + carry;
+			result[i + j] = static_cast<uint32_t>(cur % BASE);
+			carry = cur / BASE;
+		}
+		for (size_t k = i + b.size(); carry > 0; ++k) {
+			uint64_t cur = result[k] + carry;
+			result[k] = static_cast<uint32_t>(cur % BASE);
+			carry = cur / BASE;
+		}
+	}
+}
+LimbVector BigInteger::square_schoolbook(const LimbVector& a) {
+	LimbVector result(2 * a.size(), 0);
+	for (size_t i = 0; i < a.size(); ++i) {
+		uint64_t carry = 0;
+		for (size_t j = i + 1; j < a.size(); ++j) {
+			uint64_t cur = result[i + j] + 2 * static_cast<uint64_t>(a[i]) * a[j] + carry;
+			result[i + j] = static_cast<uint32_t>(cur % BASE);
+			carry = cur / BASE;
+		}
+		result[i + a.size()] = static_cast<uint32_t>(carry);
+	}
+	uint64_t carry = 0;
+	for (size_t i = 0; i < a.size(); ++i) {
+		uint64_t cur = result[2 * i] + static_cast<uint64_t>(a[i]) * a[i] + carry;
+		result[2 * i] = static_cast<uint32_t>(cur % BASE);
+		cur = result[2 * i + 1] + cur / BASE;
+		result[2 * i + 1] = static_cast<uint32_t>(cur % BASE);
+		carry = cur / BASE;
+	}
+	trim(result);
+	return result;
+}
+LimbVector BigInteger::multiply_karatsuba(const LimbVector& a, const LimbVector& b) {
+	const LimbVector& longer = a.size() < b.size() ? b : a;
+	const LimbVector& shorter = a.size() < b.size() ? a : b;
+	if (2 * shorter.size() <= longer.size()) {
+		LimbVector result;
+		for (size_t start = 0; start < longer.size(); start += shorter.size()) {
+			size_t end = min(start + shorter.size(), longer.size());
+			LimbVector chunk(longer.begin() + start, longer.begin() + end);
+			trim(chunk);
+			add_shifted(result, multiply_abs(chunk, shorter), start);
+		}
+		trim(result);
+		return result;
+	}
+
+	size_t half = (longer.size() + 1) / 2;
+	LimbVector a0(a.begin(), a.begin() + min(half, a.size()));
+	LimbVector a1(a.begin() + min(half, a.size()), a.end());
+	LimbVector b0(b.begin(), b.begin() + min(half, b.size()));
+	LimbVector b1(b.begin() + min(half, b.size()), b.end());
+	trim(a0);
+	trim(b0);
+	LimbVector a_sum = a0, b_sum = b0;
+	add_shifted(a_sum, a1, 0);
+	add_shifted(b_sum, b1, 0);
+
+	LimbVector z0, z1, z2;
+	parallel_invoke(longer.size(),
+		[&] { z0 = multiply_abs(a0, b0); },
+		[&] { z2 = multiply_abs(a1, b1); },
+		[&] { z1 = multiply_abs(a_sum, b_sum); });
+	subtract_abs(z1, z0);
+	subtract_abs(z1, z2);
+
+	LimbVector result = z0;
+	add_shifted(result, z1, half);
+	add_shifted(result, z2, 2 * half);
+	trim(result);
+	return result;
+}
+LimbVector BigInteger::square_karatsuba(const LimbVector& a) {
+	size_t half = (a.size() + 1) / 2;
+	LimbVector a0(a.begin(), a.begin() + half);
+	LimbVector a1(a.begin() + half, a.end());
+	trim(a0);
+
+	LimbVector a_sum = a0;
+	add_shifted(a_sum, a1, 0);
+
+	LimbVector z0, z1, z2;
+	parallel_invoke(a.size(),
+		[&] { z0 = square_abs(a0); },
+		[&] { z2 = square_abs(a1); },
+		[&] { z1 = square_abs(a_sum); });
+	subtract_abs(z1, z0);
+	subtract_abs(z1, z2);
+
+	LimbVector result = z0;
+	add_shifted(result, z1, half);
+	add_shifted(result, z2, 2 * half);
+	trim(result);
+	return result;
+}
+LimbVector BigInteger::multiply_toom3(const LimbVector& a, const LimbVector& b) {
+	bool square = &a == &b;
+	size_t part = (max(a.size(), b.size()) + 2) / 3;
+	auto split = [part](const LimbVector& x, BigInteger* parts) {
+		for (size_t i = 0; i < 3; ++i) {
+			size_t begin = min(i * part, x.size());
+			size_t end = min(begin + part, x.size());
+			parts[i] = from_limbs(x.data() + begin, x.data() + end);
+		}
+	};
+	auto evaluate = [](const BigInteger* parts, BigInteger* values) {
+		BigInteger even = parts[0] + parts[2];
+		values[0] = parts[0];
+		values[1] = even + parts[1];
+		values[2] = even - parts[1];
+		values[3] = (values[2] + parts[2]) * 2 - parts[0];
+		values[4] = parts[2];
+	};
+
+	BigInteger a_parts[3], a_values[5], b_parts[3], b_values[5];
+	split(a, a_parts);
+	evaluate(a_parts, a_values);
+	if (!square) {
+		split(b, b_parts);
+		evaluate(b_parts, b_values);
+	}
+	BigInteger r[5];
+	parallel_for(5, 3 * part, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			r[i] = square ? a_values[i] * a_values[i] : a_values[i] * b_values[i];
+		}
+	});
+
+	BigInteger r3 = r[3] - r[1];
+	r3.divide_small(3);
+	BigInteger r1 = r[1] - r[2];
+	r1.divide_small(2);
+	BigInteger r2 = r[2] - r[0];
+	r3 = r2 - r3;
+	r3.divide_small(2);
+	r3 += r[4] * 2;
+	r2 += r1;
+	r2 -= r[4];
+	r1 -= r3;
+
+	LimbVector result = r[0].numbers;
+	add_shifted(result, r1.numbers, part);
+	add_shifted(result, r2.numbers, 2 * part);
+	add_shifted(result, r3.numbers, 3 * part);
+	add_shifted(result, r[4].numbers, 4 * part);
+	trim(result);
+	return result;
+}
+unsigned BigInteger::acquire_threads(unsigned wanted) {
+	unsigned busy = busy_threads.load();
+	while (true) {
+		unsigned granted = busy + 1 < thread_count ? min(wanted, thread_count - 1 - busy) : 0;
+		if (granted == 0 || busy_threads.compare_exchange_weak(busy, busy + granted)) return granted;
+	}
+}
+// Splits [0, count) between the calling thread and as many pool workers as
+// the thread_count budget allows; small jobs stay on the calling thread.
+template <class Body>
+void BigInteger::parallel_for(size_t count, size_t work, Body body) {
+	unsigned extra = 0;
+	if (thread_count > 1 && count > 1 && work >= parallel_threshold) {
+		extra = acquire_threads(static_cast<unsigned>(min<size_t>(count, thread_count) - 1));
+	}
+	if (extra == 0) {
+		body(size_t(0), count);
+		return;
+	}
+	size_t parts = extra + 1;
+	vector<std::function<void()>> jobs;
+	for (size_t i = 0; i < parts; ++i) {
+		size_t begin = count * i / parts, end = count * (i + 1) / parts;
+		jobs.emplace_back([&body, begin, end] { body(begin, end); });
+	}
+	try {
+		WorkerPool::instance().run(jobs, thread_count - 1);
+	}
+	catch (...) {
+		busy_threads -= extra;
+		throw;
+	}
+	busy_threads -= extra;
+}
+template <class... Tasks>
+void BigInteger::parallel_invoke(size_t work, Tasks... tasks) {
+	if (thread_count <= 1 || work < parallel_threshold) {
+		(tasks(), ...);
+		return;
+	}
+	std::function<void()> list[] = {tasks...};
+	parallel_for(sizeof...(Tasks), work, [&list](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			list[i]();
+		}
+	});
+}
+uint32_t BigInteger::power_mod(uint64_t x, uint64_t power, uint32_t mod) {
+	uint64_t result = 1;
+	x %= mod;
+	while (power > 0) {
+		if (power & 1) result = result * x % mod;
+		x = x * x % mod;
+		power >>= 1;
+	}
+	return static_cast<uint32_t>(result);
+}
+template <uint32_t mod>
+void BigInteger::ntt(vector<uint32_t>& a, bool invert) {
+	const uint32_t root = 3;
+	size_t n = a.size();
+	for (size_t i = 1, j = 0; i < n; ++i) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+		if (i < j) std::swap(a[i], a[j]);
+	}
+	vector<uint32_t> roots;
+	for (size_t length = 2; length <= n; length <<= 1) {
+		uint32_t step = power_mod(root, (mod - 1) / length, mod);
+		if (invert) step = power_mod(step, mod - 2, mod);
+		size_t half = length / 2;
+		roots.resize(half);
+		roots[0] = 1;
+		for (size_t k = 1; k < half; ++k) {
+			roots[k] = static_cast<uint32_t>(static_cast<uint64_t>(roots[k - 1]) * step % mod);
+		}
+		for (size_t i = 0; i < n; i += length) {
+			for (size_t k = 0; k < half; ++k) {
+				uint32_t u = a[i + k];
+				uint32_t v = static_cast<uint32_t>(static_cast<uint64_t>(a[i + k + half]) * roots[k] % mod);
+				a[i + k] = u + v < mod ? u + v : u + v - mod;
+				a[i + k + half] = u >= v ? u - v : u + mod - v;
 			}
-			else {
-				right = middle;
+		}
+	}
+	if (invert) {
+		uint64_t n_inverse = power_mod(n, mod - 2, mod);
+		for (size_t i = 0; i < n; ++i) {
+			a[i] = static_cast<uint32_t>(a[i] * n_inverse % mod);
+		}
+	}
+}
+template <uint32_t mod>
+vector<uint32_t> BigInteger::convolution(const LimbVector& a, const LimbVector& b, size_t length) {
+	vector<uint32_t> fa(length, 0);
+	for (size_t i = 0; i < a.size(); ++i) {
+		fa[i] = a[i] % mod;
+	}
+	if (&a == &b) {
+		ntt<mod>(fa, false);
+		for (size_t i = 0; i < length; ++i) {
+			fa[i] = static_cast<uint32_t>(static_cast<uint64_t>(fa[i]) * fa[i] % mod);
+		}
+	}
+	else {
+		vector<uint32_t> fb(length, 0);
+		for (size_t i = 0; i < b.size(); ++i) {
+			fb[i] = b[i] % mod;
+		}
+		// Whole transforms are the unit of parallel work; a single butterfly
+		// stage is too short to be worth a fork.
+		parallel_invoke(length, [&] { ntt<mod>(fa, false); }, [&] { ntt<mod>(fb, false); });
+		for (size_t i = 0; i < length; ++i) {
+			fa[i] = static_cast<uint32_t>(static_cast<uint64_t>(fa[i]) * fb[i] % mod);
+		}
+	}
+	ntt<mod>(fa, true);
+	return fa;
+}
+LimbVector BigInteger::multiply_ntt(const LimbVector& a, const LimbVector& b) {
+	const uint32_t mod1 = 998244353, mod2 = 167772161, mod3 = 469762049;
+	size_t length = 1;
+	while (length < a.size() + b.size()) {
+		length <<= 1;
+	}
+	vector<uint32_t> r1, r2, r3;
+	parallel_invoke(length,
+		[&] { r1 = convolution<mod1>(a, b, length); },
+		[&] { r2 = convolution<mod2>(a, b, length); },
+		[&] { r3 = convolution<mod3>(a, b, length); });
+
+	const uint64_t mod1_inverse = power_mod(mod1, mod2 - 2, mod2);
+	const uint64_t mod12_inverse = power_mod(static_cast<uint64_t>(mod1) * mod2 % mod3, mod3 - 2, mod3);
+	const uint64_t mod12 = static_cast<uint64_t>(mod1) * mod2;
+	LimbVector result(a.size() + b.size(), 0);
+	unsigned __int128 carry = 0;
+	for (size_t i = 0; i < result.size(); ++i) {
+		uint64_t t2 = (r2[i] + mod2 - r1[i] % mod2) % mod2 * mod1_inverse % mod2;
+		uint64_t x12 = r1[i] + mod1 * t2;
+		uint64_t t3 = (r3[i] + mod3 - x12 % mod3) % mod3 * mod12_inverse % mod3;
+		carry += x12 + static_cast<unsigned __int128>(mod12) * t3;
+		result[i] = static_cast<uint32_t>(carry % BASE);
+		carry /= BASE;
+	}
+	trim(result);
+	return result;
+}
+
+void BigInteger::divide_abs(const LimbVector& a, const LimbVector& b, LimbVector& quotient, LimbVector& remainder) {
+	if (compare_limbs(a, b) < 0) {
+		quotient.clear();
+		remainder = a;
+		return;
+	}
+	if (b.size() == 1) {
+		quotient.assign(a.size(), 0);
+		uint64_t rest = 0;
+		for (size_t i = a.size(); i > 0;) {
+			--i;
+			uint64_t cur = a[i] + rest * BASE;
+			quotient[i] = static_cast<uint32_t>(cur / b[0]);
+			rest = cur % b[0];
+		}
+		trim(quotient);
+		remainder.assign(1, static_cast<uint32_t>(rest));
+		trim(remainder);
+		return;
+	}
+	// Knuth costs O(quotient * divisor), so a short quotient never pays for
+	// a full-size reciprocal.
+	if (b.size() >= newton_threshold && a.size() - b.size() >= newton_threshold) {
+		divide_newton(a, b, quotient, remainder);
+	}
+	else {
+		divide_knuth(a, b, quotient, remainder);
+	}
+}
+void BigInteger::divide_knuth(const LimbVector& a, const LimbVector& b, LimbVector& quotient, LimbVector& remainder) {
+	uint32_t scale = BASE / (b.back() + 1);
+	LimbVector u = multiply_small(a, scale);
+	LimbVector v = multiply_small(b, scale);
+	size_t n = v.size();
+	size_t m = a.size() - n;
+	u.resize(a.size() + 1, 0);
+	quotient.assign(m + 1, 0);
+
+	for (size_t j = m + 1; j > 0;) {
+		--j;
+		uint64_t top = static_cast<uint64_t>(u[j + n]) * BASE + u[j + n - 1];
+		uint64_t q = top / v[n - 1];
+		uint64_t r = top % v[n - 1];
+		while (q >= BASE || q * v[n - 2] > r * BASE + u[j + n - 2]) {
+			--q;
+			r += v[n - 1];
+			if (r >= BASE) break;
+		}
+
+		uint64_t carry = 0;
+		int64_t borrow = 0;
+		for (size_t i = 0; i < n; ++i) {
+			uint64_t product = q * v[i] + carry;
+			carry = product / BASE;
+			int64_t diff = static_cast<int64_t>(u[i + j]) - static_cast<int64_t>(product % BASE) - borrow;
+			borrow = diff < 0;
+			if (borrow) diff += BASE;
+			u[i + j] = static_cast<uint32_t>(diff);
+		}
+		int64_t diff = static_cast<int64_t>(u[j + n]) - static_cast<int64_t>(carry) - borrow;
+		if (diff < 0) {
+			--q;
+			u[j + n] = static_cast<uint32_t>(diff + BASE);
+			uint32_t add_carry = 0;
+			for (size_t i = 0; i < n; ++i) {
+				uint32_t sum = u[i + j] + v[i] + add_carry;
+				add_carry = sum >= BASE;
+				if (add_carry) sum -= BASE;
+				u[i + j] = sum;
 			}
+			u[j + n] = (u[j + n] + add_carry) % BASE;
 		}
+		else {
+			u[j + n] = static_cast<uint32_t>(diff);
+		}
+		quotient[j] = static_cast<uint32_t>(q);
+	}
+	trim(quotient);
 
-		result.push_back(left);
-		tmp.decrease(left * x);
+	u.resize(n);
+	remainder.assign(n, 0);
+	uint64_t rest = 0;
+	for (size_t i = n; i > 0;) {
+		--i;
+		uint64_t cur = u[i] + rest * BASE;
+		remainder[i] = static_cast<uint32_t>(cur / scale);
+		rest = cur % scale;
+	}
+	trim(remainder);
+}
+LimbVector BigInteger::reciprocal(const LimbVector& b) {
+	size_t n = b.size();
+	LimbVector power(2 * n + 1, 0);
+	power.back() = 1;
+	if (n <= max<size_t>(newton_threshold, 8)) {
+		LimbVector quotient, remainder;
+		divide_knuth(power, b, quotient, remainder);
+		return quotient;
+	}
 
+	size_t h = n / 2 + 2;
+	LimbVector top(b.end() - h, b.end());
+	LimbVector x = reciprocal(top);
+	x.insert(x.begin(), n - h, 0);
+
+	LimbVector product = multiply_abs(b, x);
+	bool below = compare_limbs(product, power) <= 0;
+	LimbVector error = below ? power : product;
+	subtract_abs(error, below ? product : power);
+	LimbVector correction = multiply_abs(x, error);
+	correction.erase(correction.begin(), correction.begin() + min(2 * n, correction.size()));
+	if (below) {
+		add_shifted(x, correction, 0);
+	}
+	else {
+		add_shifted(correction, LimbVector(1, 1), 0);
+		subtract_abs(x, correction);
 	}
 
-	for (size_t i = 0; i < result.size() / 2; ++i) {
-		std::swap(result[i], result[result.size() - 1 - i]);
+	return x;
+}
+void BigInteger::divide_newton(const LimbVector& a, const LimbVector& b, LimbVector& quotient, LimbVector& remainder) {
+	size_t n = b.size();
+	const LimbVector one(1, 1);
+	LimbVector x = reciprocal(b);
+	quotient.assign(a.size(), 0);
+	remainder.clear();
+
+	size_t position = a.size() - min(a.size(), 2 * n);
+	size_t length = a.size() - position;
+	while (true) {
+		LimbVector current(a.begin() + position, a.begin() + position + length);
+		current.insert(current.end(), remainder.begin(), remainder.end());
+		trim(current);
+
+		LimbVector q = multiply_abs(current, x);
+		q.erase(q.begin(), q.begin() + min(2 * n, q.size()));
+		LimbVector product = multiply_abs(q, b);
+		while (compare_limbs(product, current) > 0) {
+			subtract_abs(q, one);
+			subtract_abs(product, b);
+		}
+		subtract_abs(current, product);
+		while (compare_limbs(current, b) >= 0) {
+			add_shifted(q, one, 0);
+			subtract_abs(current, b);
+		}
+		copy(q.begin(), q.end(), quotient.begin() + position);
+		remainder = current;
+		if (position == 0) break;
+		length = min(n, position);
+		position -= length;
 	}
-	numbers = result;
-	sign ^= !x.sign;
-	norm();
-	return *this;
+	trim(quotient);
+}
+LimbVector BigInteger::divide_exact_abs(const LimbVector& a, const LimbVector& b) {
+	LimbVector quotient, remainder;
+	if (compare_limbs(a, b) < 0) return quotient;
+	size_t length = a.size() - b.size() + 1;
+	if (b.size() <= length + 1) {
+		divide_abs(a, b, quotient, remainder);
+		return quotient;
+	}
+
+	size_t shift = b.size() - length - 1;
+	divide_abs(LimbVector(a.begin() + shift, a.end()), LimbVector(b.begin() + shift, b.end()), quotient, remainder);
+	size_t low = 0;
+	while (b[low] == 0) {
+		++low;
+	}
+	uint64_t expected = quotient.empty() ? 0 : static_cast<uint64_t>(quotient[0]) * b[low] % BASE;
+	if (expected != a[low]) {
+		add_shifted(quotient, LimbVector(1, 1), 0);
+	}
+	return quotient;
+}
+BigInteger& BigInteger::operator/=(const BigInteger& x) {
+	return *this = divmod(*this, x).first;
 }
 BigInteger& BigInteger::operator%=(const BigInteger& x) {
-	return *this -= *this / x * x;
+	return *this = divmod(*this, x).second;
+}
+
+pair<BigInteger, BigInteger> divmod(const BigInteger& a, const BigInteger& b) {
+	pair<BigInteger, BigInteger> result;
+	BigInteger::divide_abs(a.numbers, b.numbers, result.first.numbers, result.second.numbers);
+	result.first.sign = a.sign == b.sign;
+	result.second.sign = a.sign;
+	result.first.norm();
+	result.second.norm();
+	return result;
+}
+
+BigInteger divexact(const BigInteger& a, const BigInteger& b) {
+	BigInteger result;
+	result.numbers = BigInteger::divide_exact_abs(a.numbers, b.numbers);
+	result.sign = a.sign == b.sign;
+	result.norm();
+	return result;
+}
+
+uint64_t BigInteger::gcd_word(uint64_t a, uint64_t b) {
+	if (a == 0) return b;
+	if (b == 0) return a;
+	int shift = __builtin_ctzll(a | b);
+	a >>= __builtin_ctzll(a);
+	while (b != 0) {
+		b >>= __builtin_ctzll(b);
+		if (a > b) std::swap(a, b);
+		b -= a;
+	}
+	return a << shift;
+}
+void BigInteger::combine(const LimbVector& a, const LimbVector& b, int64_t x, int64_t y, LimbVector& result) {
+	result.assign(a.size(), 0);
+	int64_t carry = 0;
+	for (size_t i = 0; i < a.size(); ++i) {
+		int64_t cur = x * a[i] + carry;
+		if (i < b.size()) cur += y * b[i];
+		carry = cur / BASE;
+		cur %= BASE;
+		if (cur < 0) {
+			cur += BASE;
+			--carry;
+		}
+		result[i] = static_cast<uint32_t>(cur);
+	}
+	trim(result);
+}
+LimbVector BigInteger::gcd_abs(LimbVector a, LimbVector b) {
+	const int64_t cofactor_limit = int64_t(1) << 31;
+	trim(a);
+	trim(b);
+	if (compare_limbs(a, b) < 0) std::swap(a, b);
+	LimbVector quotient, remainder, next_a, next_b;
+	while (b.size() > WORD_LIMBS) {
+		size_t n = a.size();
+		int64_t a_top = static_cast<int64_t>(a[n - 1]) * BASE + a[n - 2];
+		int64_t b_top = (b.size() >= n ? static_cast<int64_t>(b[n - 1]) * BASE : 0) + (b.size() >= n - 1 ? b[n - 2] : 0);
+		int64_t x0 = 1, y0 = 0, x1 = 0, y1 = 1;
+		while (b_top + x1 != 0 && b_top + y1 != 0) {
+			int64_t q = (a_top + x0) / (b_top + x1);
+			if (q != (a_top + y0) / (b_top + y1)) break;
+			int64_t x2 = x0 - q * x1, y2 = y0 - q * y1;
+			if (x2 >= cofactor_limit || -x2 >= cofactor_limit || y2 >= cofactor_limit || -y2 >= cofactor_limit) break;
+			x0 = x1;
+			x1 = x2;
+			y0 = y1;
+			y1 = y2;
+			int64_t t = a_top - q * b_top;
+			a_top = b_top;
+			b_top = t;
+		}
+
+		if (y0 == 0) {
+			divide_abs(a, b, quotient, remainder);
+			std::swap(a, b);
+			std::swap(b, remainder);
+		}
+		else {
+			combine(a, b, x0, y0, next_a);
+			combine(a, b, x1, y1, next_b);
+			std::swap(a, next_a);
+			std::swap(b, next_b);
+		}
+	}
+
+	if (b.empty()) return a;
+	uint64_t b_word = b[0] + (b.size() > 1 ? static_cast<uint64_t>(b[1]) * BASE : 0);
+	unsigned __int128 rest = 0;
+	for (size_t i = a.size(); i > 0;) {
+		--i;
+		rest = (rest * BASE + a[i]) % b_word;
+	}
+	uint64_t result = gcd_word(b_word, static_cast<uint64_t>(rest));
+	LimbVector limbs;
+	limbs.push_back(static_cast<uint32_t>(result % BASE));
+	limbs.push_back(static_cast<uint32_t>(result / BASE));
+	trim(limbs);
+	return limbs;
+}
+BigInteger gcd(const BigInteger& a, const BigInteger& b) {
+	BigInteger result;
+	if (a.numbers.size() <= BigInteger::WORD_LIMBS && b.numbers.size() <= BigInteger::WORD_LIMBS) {
+		int64_t x = a.to_word(), y = b.to_word();
+		result.assign_native(BigInteger::gcd_word(x < 0 ? -x : x, y < 0 ? -y : y));
+		return result;
+	}
+	result.numbers = BigInteger::gcd_abs(a.numbers, b.numbers);
+	result.norm();
+	return result;
+}
+
+BigInteger& BigInteger::multiply_power_of_ten(size_t exponent) {
+	if (numbers.size() == 1 && numbers[0] == 0) return *this;
+	if (exponent % BASE_DIGITS != 0) {
+		numbers = multiply_small(numbers, POWERS_OF_TEN[exponent % BASE_DIGITS]);
+	}
+	numbers.insert(numbers.begin(), exponent / BASE_DIGITS, 0);
+	return *this;
+}
+BigInteger BigInteger::powerOfTen(size_t exponent) {
+	return BigInteger(1).multiply_power_of_ten(exponent);
+}
+BigInteger pow(const BigInteger& base, uint64_t exponent) {
+	if (base.sign && base.numbers.size() == 1 && base.numbers[0] == 10) {
+		return BigInteger::powerOfTen(exponent);
+	}
+	BigInteger result = 1;
+	if (exponent == 0) return result;
+	result = base;
+	for (int bit = 62 - __builtin_clzll(exponent); bit >= 0; --bit) {
+		result = result * result;
+		if ((exponent >> bit) & 1) result *= base;
+	}
+	return result;
+}
+// Upper bound for the root: the exact root of the leading half, or a double
+// estimate of the leading limbs for short inputs.
+BigInteger BigInteger::root_estimate(const BigInteger& x, unsigned degree) {
+	const LimbVector& limbs = x.numbers;
+	size_t shift = limbs.size() / (2 * static_cast<size_t>(degree));
+	if (shift >= WORD_LIMBS) {
+		BigInteger result = iroot(from_limbs(limbs.data() + shift * degree, limbs.data() + limbs.size()), degree);
+		++result;
+		result.numbers.insert(result.numbers.begin(), shift, 0);
+		return result;
+	}
+	double top = limbs.back();
+	if (limbs.size() > 1) top += limbs[limbs.size() - 2] / static_cast<double>(BASE);
+	double bits = log2(top) + (limbs.size() - 1) * log2(static_cast<double>(BASE));
+	double exponent = (bits * (1 + 1e-14) + 1e-6) / degree;
+	double whole = floor(exponent);
+	uint64_t mantissa = static_cast<uint64_t>(exp2(exponent - whole + 52)) + 2;
+	BigInteger result;
+	if (whole < 52) {
+		result.assign_native((mantissa >> static_cast<int>(52 - whole)) + 1);
+		return result;
+	}
+	result.assign_native(mantissa);
+	return result * pow(BigInteger(2), static_cast<uint64_t>(whole) - 52);
+}
+BigInteger isqrt(const BigInteger& x) {
+	if (!x.sign) {
+		throw std::domain_error("square root of a negative number");
+	}
+	if (x.numbers.size() == 1 && x.numbers[0] == 0) return x;
+	BigInteger result = BigInteger::root_estimate(x, 2);
+	while (true) {
+		BigInteger next = result + x / result;
+		next.divide_small(2);
+		if (next >= result) return result;
+		result = std::move(next);
+	}
+}
+BigInteger iroot(const BigInteger& x, unsigned degree) {
+	if (degree == 0 || (!x.sign && degree % 2 == 0)) {
+		throw std::domain_error("root is not defined");
+	}
+	if (!x.sign) return -iroot(-x, degree);
+	if (degree == 1 || (x.numbers.size() == 1 && x.numbers[0] <= 1)) return x;
+	if (degree == 2) return isqrt(x);
+	BigInteger result = BigInteger::root_estimate(x, degree);
+	if (result.numbers.size() == 1 && result.numbers[0] <= 2) {
+		return pow(BigInteger(2), degree) <= x ? 2 : 1;
+	}
+	while (true) {
+		BigInteger next = result * (degree - 1) + x / pow(result, degree - 1);
+		next.divide_small(degree);
+		if (next >= result) return result;
+		result = std::move(next);
+	}
+}
+template <class Iterator>
+BigInteger product(Iterator first, Iterator last) {
+	vector<BigInteger> level(first, last);
+	if (level.empty()) return 1;
+	while (level.size() > 1) {
+		size_t work = 0;
+		for (const BigInteger& x : level) {
+			work += x.numbers.size();
+		}
+		vector<BigInteger> next((level.size() + 1) / 2);
+		BigInteger::parallel_for(next.size(), work, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				next[i] = 2 * i + 1 < level.size() ? std::move(level[2 * i]) * level[2 * i + 1] : std::move(level[2 * i]);
+			}
+		});
+		level.swap(next);
+	}
+	return std::move(level[0]);
 }
 
 BigInteger operator+(const BigInteger& a, const BigInteger& b) {
@@ -223,6 +1830,12 @@ BigInteger operator-(const  BigInteger& a, const BigInteger& b) {
 	return result;
 }
 BigInteger operator*(const BigInteger& a, const BigInteger& b) {
+	if (&a == &b) {
+		BigInteger result;
+		result.numbers = BigInteger::square_abs(a.numbers);
+		result.norm();
+		return result;
+	}
 	BigInteger result = a;
 	result *= b;
 	return result;
@@ -238,6 +1851,151 @@ BigInteger operator%(const BigInteger& a, const BigInteger& b) {
 	return result;
 }
 
+BigInteger operator+(BigInteger&& a, const BigInteger& b) {
+	a += b;
+	return std::move(a);
+}
+BigInteger operator+(const BigInteger& a, BigInteger&& b) {
+	b += a;
+	return std::move(b);
+}
+BigInteger operator+(BigInteger&& a, BigInteger&& b) {
+	a += b;
+	return std::move(a);
+}
+BigInteger operator-(BigInteger&& a, const BigInteger& b) {
+	a -= b;
+	return std::move(a);
+}
+BigInteger operator-(const BigInteger& a, BigInteger&& b) {
+	b -= a;
+	b.sign ^= true;
+	b.norm();
+	return std::move(b);
+}
+BigInteger operator-(BigInteger&& a, BigInteger&& b) {
+	a -= b;
+	return std::move(a);
+}
+BigInteger operator*(BigInteger&& a, const BigInteger& b) {
+	a *= b;
+	return std::move(a);
+}
+BigInteger operator*(const BigInteger& a, BigInteger&& b) {
+	b *= a;
+	return std::move(b);
+}
+BigInteger operator*(BigInteger&& a, BigInteger&& b) {
+	a *= b;
+	return std::move(a);
+}
+BigInteger operator/(BigInteger&& a, const BigInteger& b) {
+	a /= b;
+	return std::move(a);
+}
+BigInteger operator%(BigInteger&& a, const BigInteger& b) {
+	a %= b;
+	return std::move(a);
+}
+
+BigIntegerProduct mul(const BigInteger& a, const BigInteger& b) {
+	return BigIntegerProduct{&a, &b, false};
+}
+BigIntegerProduct operator-(const BigIntegerProduct& x) {
+	return BigIntegerProduct{x.left, x.right, !x.negative};
+}
+BigIntegerProductSum<2> operator+(const BigIntegerProduct& a, const BigIntegerProduct& b) {
+	return BigIntegerProductSum<2>{{a, b}};
+}
+BigIntegerProductSum<2> operator-(const BigIntegerProduct& a, const BigIntegerProduct& b) {
+	return BigIntegerProductSum<2>{{a, -b}};
+}
+template <size_t N>
+BigIntegerProductSum<N + 1> operator+(const BigIntegerProductSum<N>& a, const BigIntegerProduct& b) {
+	BigIntegerProductSum<N + 1> result;
+	copy(a.terms, a.terms + N, result.terms);
+	result.terms[N] = b;
+	return result;
+}
+template <size_t N>
+BigIntegerProductSum<N + 1> operator-(const BigIntegerProductSum<N>& a, const BigIntegerProduct& b) {
+	return a + -b;
+}
+
+BigInteger::BigInteger(const BigIntegerProduct& x) : BigInteger(0) {
+	accumulate(&x, 1, false);
+}
+template <size_t N>
+BigInteger::BigInteger(const BigIntegerProductSum<N>& x) : BigInteger(0) {
+	accumulate(x.terms, N, false);
+}
+BigInteger& BigInteger::operator=(const BigIntegerProduct& x) {
+	return assign_products(&x, 1);
+}
+template <size_t N>
+BigInteger& BigInteger::operator=(const BigIntegerProductSum<N>& x) {
+	return assign_products(x.terms, N);
+}
+BigInteger& BigInteger::operator+=(const BigIntegerProduct& x) {
+	return accumulate(&x, 1, false);
+}
+BigInteger& BigInteger::operator-=(const BigIntegerProduct& x) {
+	return accumulate(&x, 1, true);
+}
+template <size_t N>
+BigInteger& BigInteger::operator+=(const BigIntegerProductSum<N>& x) {
+	return accumulate(x.terms, N, false);
+}
+template <size_t N>
+BigInteger& BigInteger::operator-=(const BigIntegerProductSum<N>& x) {
+	return accumulate(x.terms, N, true);
+}
+BigInteger& BigInteger::addmul(const BigInteger& a, const BigInteger& b) {
+	return add_product(a, b, false);
+}
+BigInteger& BigInteger::submul(const BigInteger& a, const BigInteger& b) {
+	return add_product(a, b, true);
+}
+bool BigInteger::is_referenced(const BigIntegerProduct* terms, size_t count) const {
+	for (size_t i = 0; i < count; ++i) {
+		if (terms[i].left == this || terms[i].right == this) return true;
+	}
+	return false;
+}
+BigInteger& BigInteger::assign_products(const BigIntegerProduct* terms, size_t count) {
+	if (is_referenced(terms, count)) {
+		BigInteger result(0);
+		result.accumulate(terms, count, false);
+		return *this = std::move(result);
+	}
+	numbers.assign(1, 0);
+	sign = true;
+	return accumulate(terms, count, false);
+}
+BigInteger& BigInteger::accumulate(const BigIntegerProduct* terms, size_t count, bool negative) {
+	if (is_referenced(terms, count)) {
+		BigInteger result(0);
+		result.accumulate(terms, count, negative);
+		return *this += result;
+	}
+	for (size_t i = 0; i < count; ++i) {
+		add_product(*terms[i].left, *terms[i].right, terms[i].negative != negative);
+	}
+	return *this;
+}
+BigInteger& BigInteger::add_product(const BigInteger& a, const BigInteger& b, bool negative) {
+	bool product_sign = (a.sign == b.sign) != negative;
+	bool is_zero = numbers.size() == 1 && numbers[0] == 0;
+	if (&a == this || &b == this || (sign != product_sign && !is_zero)
+		|| min(a.numbers.size(), b.numbers.size()) >= karatsuba_threshold) {
+		return negative ? *this -= a * b : *this += a * b;
+	}
+	if (is_zero) sign = product_sign;
+	multiply_accumulate(numbers, a.numbers, b.numbers);
+	norm();
+	return *this;
+}
+
 BigInteger& BigInteger::operator++() {
 	return *this += 1;
 }
@@ -246,110 +2004,602 @@ BigInteger BigInteger::operator++(int) {
 	++* this;
 	return copy;
 }
-BigInteger& BigInteger::operator--() {
-	return *this -= 1;
+BigInteger& BigInteger::operator--() {
+	return *this -= 1;
+}
+BigInteger BigInteger::operator--(int) {
+	BigInteger copy = *this;
+	--* this;
+	return copy;
+}
+
+bool operator==(const BigInteger& a, const BigInteger& b) {
+	return a.sign == b.sign && a.numbers == b.numbers;
+}
+bool operator<(const BigInteger& a, const BigInteger& b) {
+	return BigInteger::compare(a, b) < 0;
+}
+bool operator>(const BigInteger& a, const BigInteger& b) {
+	return b < a;
+}
+bool operator!=(const BigInteger& a, const BigInteger& b) {
+	return !(a == b);
+}
+bool operator<=(const BigInteger& a, const BigInteger& b) {
+	return !(a > b);
+}
+bool operator>=(const BigInteger& a, const BigInteger& b) {
+	return !(a < b);
+}
+#if __cplusplus >= 202002L
+std::strong_ordering operator<=>(const BigInteger& a, const BigInteger& b) {
+	return BigInteger::compare(a, b) <=> 0;
+}
+#endif
+
+template <class T>
+bool BigInteger::word_negative(T x) {
+	if constexpr (std::is_signed<T>::value) return x < 0;
+	else return false;
+}
+template <class T>
+uint64_t BigInteger::word_magnitude(T x) {
+	if constexpr (std::is_signed<T>::value) return x < 0 ? 0 - static_cast<uint64_t>(x) : static_cast<uint64_t>(x);
+	else return static_cast<uint64_t>(x);
+}
+BigInteger& BigInteger::add_word(uint64_t magnitude, bool negative) {
+	if (numbers.size() <= 3) {
+		__int128 value = static_cast<__int128>(to_native());
+		if (!sign) value = -value;
+		value += negative ? -static_cast<__int128>(magnitude) : static_cast<__int128>(magnitude);
+		sign = value >= 0;
+		assign_native(static_cast<unsigned __int128>(sign ? value : -value));
+		return *this;
+	}
+	uint32_t limbs[3] = {static_cast<uint32_t>(magnitude % BASE), static_cast<uint32_t>(magnitude / BASE % BASE),
+		static_cast<uint32_t>(magnitude / BASE / BASE)};
+	if (sign != negative) {
+		propagate_carry(numbers, 3, add_limbs_scalar(numbers.data(), numbers.data(), limbs, 3, 0));
+	}
+	else {
+		propagate_borrow(numbers, 3, subtract_limbs_scalar(numbers.data(), numbers.data(), limbs, 3, 0));
+		norm();
+	}
+	return *this;
+}
+BigInteger& BigInteger::multiply_word(uint64_t magnitude, bool negative) {
+	sign ^= negative;
+	if (magnitude < BASE) {
+		uint64_t carry = 0;
+		for (size_t i = 0; i < numbers.size(); ++i) {
+			carry += static_cast<uint64_t>(numbers[i]) * magnitude;
+			numbers[i] = static_cast<uint32_t>(carry % BASE);
+			carry /= BASE;
+		}
+		for (; carry > 0; carry /= BASE) {
+			numbers.push_back(static_cast<uint32_t>(carry % BASE));
+		}
+		norm();
+		return *this;
+	}
+	uint64_t low = magnitude % BASE, middle = magnitude / BASE % BASE, high = magnitude / BASE / BASE;
+	size_t length = numbers.size();
+	numbers.resize(length + 3, 0);
+	uint64_t carry = 0, previous = 0, before_previous = 0;
+	for (size_t i = 0; i < numbers.size(); ++i) {
+		uint64_t current = numbers[i];
+		carry += current * low + previous * middle + before_previous * high;
+		numbers[i] = static_cast<uint32_t>(carry % BASE);
+		carry /= BASE;
+		before_previous = previous;
+		previous = current;
+	}
+	norm();
+	return *this;
+}
+uint64_t BigInteger::divide_word(uint64_t magnitude) {
+	if (magnitude <= UINT32_MAX) return divide_small(static_cast<uint32_t>(magnitude));
+	unsigned __int128 rest = 0;
+	for (size_t i = numbers.size(); i > 0;) {
+		--i;
+		rest = rest * BASE + numbers[i];
+		numbers[i] = static_cast<uint32_t>(rest / magnitude);
+		rest %= magnitude;
+	}
+	norm();
+	return static_cast<uint64_t>(rest);
+}
+int BigInteger::compare_word(uint64_t magnitude, bool negative) const {
+	if (numbers.size() > 3) return sign ? 1 : -1;
+	__int128 value = static_cast<__int128>(to_native());
+	if (!sign) value = -value;
+	__int128 other = negative ? -static_cast<__int128>(magnitude) : static_cast<__int128>(magnitude);
+	return value < other ? -1 : value > other;
+}
+
+template <class T, class>
+BigInteger& BigInteger::operator+=(T x) {
+	return add_word(word_magnitude(x), word_negative(x));
+}
+template <class T, class>
+BigInteger& BigInteger::operator-=(T x) {
+	return add_word(word_magnitude(x), !word_negative(x) && x != 0);
+}
+template <class T, class>
+BigInteger& BigInteger::operator*=(T x) {
+	return multiply_word(word_magnitude(x), word_negative(x));
+}
+template <class T, class>
+BigInteger& BigInteger::operator/=(T x) {
+	divide_word(word_magnitude(x));
+	sign ^= word_negative(x);
+	norm();
+	return *this;
+}
+template <class T, class>
+BigInteger& BigInteger::operator%=(T x) {
+	bool negative = !sign;
+	assign_native(divide_word(word_magnitude(x)));
+	sign = !negative;
+	norm();
+	return *this;
+}
+
+template <class T>
+IfWord<T> operator+(const BigInteger& a, T b) {
+	BigInteger result = a;
+	return result += b;
+}
+template <class T>
+IfWord<T> operator-(const BigInteger& a, T b) {
+	BigInteger result = a;
+	return result -= b;
+}
+template <class T>
+IfWord<T> operator*(const BigInteger& a, T b) {
+	BigInteger result = a;
+	return result *= b;
+}
+template <class T>
+IfWord<T> operator/(const BigInteger& a, T b) {
+	BigInteger result = a;
+	return result /= b;
+}
+template <class T>
+IfWord<T> operator%(const BigInteger& a, T b) {
+	BigInteger result = a;
+	return result %= b;
+}
+template <class T>
+IfWord<T> operator+(BigInteger&& a, T b) {
+	a += b;
+	return std::move(a);
+}
+template <class T>
+IfWord<T> operator-(BigInteger&& a, T b) {
+	a -= b;
+	return std::move(a);
+}
+template <class T>
+IfWord<T> operator*(BigInteger&& a, T b) {
+	a *= b;
+	return std::move(a);
+}
+template <class T>
+IfWord<T> operator/(BigInteger&& a, T b) {
+	a /= b;
+	return std::move(a);
+}
+template <class T>
+IfWord<T> operator%(BigInteger&& a, T b) {
+	a %= b;
+	return std::move(a);
+}
+
+template <class T>
+IfWordTest<T> operator==(const BigInteger& a, T b) {
+	return a.compare_word(BigInteger::word_magnitude(b), BigInteger::word_negative(b)) == 0;
+}
+template <class T>
+IfWordTest<T> operator!=(const BigInteger& a, T b) {
+	return !(a == b);
+}
+template <class T>
+IfWordTest<T> operator<(const BigInteger& a, T b) {
+	return a.compare_word(BigInteger::word_magnitude(b), BigInteger::word_negative(b)) < 0;
+}
+template <class T>
+IfWordTest<T> operator>(const BigInteger& a, T b) {
+	return b < a;
+}
+template <class T>
+IfWordTest<T> operator<=(const BigInteger& a, T b) {
+	return !(b < a);
+}
+template <class T>
+IfWordTest<T> operator>=(const BigInteger& a, T b) {
+	return !(a < b);
+}
+template <class T>
+IfWordTest<T> operator==(T a, const BigInteger& b) {
+	return b == a;
+}
+template <class T>
+IfWordTest<T> operator!=(T a, const BigInteger& b) {
+	return !(b == a);
+}
+template <class T>
+IfWordTest<T> operator<(T a, const BigInteger& b) {
+	return b.compare_word(BigInteger::word_magnitude(a), BigInteger::word_negative(a)) > 0;
+}
+template <class T>
+IfWordTest<T> operator>(T a, const BigInteger& b) {
+	return b < a;
+}
+template <class T>
+IfWordTest<T> operator<=(T a, const BigInteger& b) {
+	return !(b < a);
+}
+template <class T>
+IfWordTest<T> operator>=(T a, const BigInteger& b) {
+	return !(a < b);
+}
+#if __cplusplus >= 202002L
+template <class T>
+std::enable_if_t<std::is_integral<T>::value, std::strong_ordering> operator<=>(const BigInteger& a, T b) {
+	return a.compare_word(BigInteger::word_magnitude(b), BigInteger::word_negative(b)) <=> 0;
+}
+#endif
+
+BigInteger::operator bool() const {
+	return numbers.size() > 1 || numbers[0] != 0;
+}
+string BigInteger::toString() const {
+	string s(charsLength(), '0');
+	toChars(&s[0]);
+	return s;
+}
+size_t BigInteger::limb_digits(uint32_t limb) {
+	size_t digits = 1;
+	while (digits < BASE_DIGITS && limb >= POWERS_OF_TEN[digits]) {
+		++digits;
+	}
+	return digits;
+}
+size_t BigInteger::charsLength() const {
+	return (sign ? 0 : 1) + (numbers.size() - 1) * BASE_DIGITS + limb_digits(numbers.back());
+}
+char* BigInteger::toChars(char* buffer) const {
+	if (!sign) *buffer++ = '-';
+	uint32_t top = numbers.back();
+	char* end = buffer + limb_digits(top);
+	for (char* position = end; position != buffer; top /= 10) {
+		*--position = static_cast<char>('0' + top % 10);
+	}
+	for (size_t i = numbers.size() - 1; i > 0;) {
+		--i;
+		uint32_t limb = numbers[i];
+		for (size_t j = BASE_DIGITS; j > 0; limb /= 10) {
+			end[--j] = static_cast<char>('0' + limb % 10);
+		}
+		end += BASE_DIGITS;
+	}
+	return end;
+}
+void BigInteger::assign_chars(const char* begin, const char* end) {
+	sign = true;
+	if (begin != end && *begin == '-') {
+		sign = false;
+		++begin;
+	}
+	numbers.clear();
+	numbers.reserve((end - begin) / BASE_DIGITS + 1);
+	while (end != begin) {
+		const char* start = end - begin > static_cast<ptrdiff_t>(BASE_DIGITS) ? end - BASE_DIGITS : begin;
+		uint32_t limb = 0;
+		for (const char* position = start; position != end; ++position) {
+			limb = limb * 10 + static_cast<uint32_t>(*position - '0');
+		}
+		numbers.push_back(limb);
+		end = start;
+	}
+	norm();
+}
+
+std::ostream& operator<<(std::ostream& out, const BigInteger& x) {
+	out << x.toString();
+	return out;
 }
-BigInteger BigInteger::operator--(int) {
-	BigInteger copy = *this;
-	--* this;
-	return copy;
+std::istream& operator>>(std::istream& in, BigInteger& x) {
+	string s;
+	in >> s;
+	x.assign_chars(s.data(), s.data() + s.size());
+	return in;
 }
 
-bool operator==(const BigInteger& a, const BigInteger& b) {
-	if (a.numbers.size() != b.numbers.size()) return false;
-	if (a.sign != b.sign) return false;
-	for (size_t i = 0; i < a.numbers.size(); ++i) {
-		if (a.numbers[i] != b.numbers[i]) return false;
+
+// Unsigned integer of a fixed number of bits (a multiple of 64) with
+// arithmetic modulo 2^Bits. Every loop has a compile-time trip count, so
+// the kernels unroll, and everything except the BigInteger conversions is
+// constexpr.
+template <size_t Bits>
+class FixedInteger {
+	static_assert(Bits > 0 && Bits % 64 == 0, "FixedInteger width must be a positive multiple of 64");
+
+public:
+	static constexpr size_t WORDS = Bits / 64;
+
+	constexpr FixedInteger() : words{} {}
+	constexpr FixedInteger(uint64_t x) : words{x} {}
+	explicit FixedInteger(const BigInteger& x);
+	explicit operator BigInteger() const;
+
+	constexpr uint64_t word(size_t index) const { return words[index]; }
+
+	constexpr FixedInteger& operator+=(const FixedInteger& x) {
+		uint64_t carry = 0;
+		for (size_t i = 0; i < WORDS; ++i) {
+			unsigned __int128 sum = static_cast<unsigned __int128>(words[i]) + x.words[i] + carry;
+			words[i] = static_cast<uint64_t>(sum);
+			carry = static_cast<uint64_t>(sum >> 64);
+		}
+		return *this;
 	}
-	return true;
-}
-bool operator<(const BigInteger& a, const BigInteger& b) {
-	if (a.sign < b.sign) return true;
-	if (a.sign > b.sign) return false;
-	if (a.sign) {
-		if (b.numbers.size() < a.numbers.size()) return false;
-		if (b.numbers.size() > a.numbers.size()) return true;
+	constexpr FixedInteger& operator-=(const FixedInteger& x) {
+		uint64_t borrow = 0;
+		for (size_t i = 0; i < WORDS; ++i) {
+			unsigned __int128 difference = static_cast<unsigned __int128>(words[i]) - x.words[i] - borrow;
+			words[i] = static_cast<uint64_t>(difference);
+			borrow = static_cast<uint64_t>(difference >> 64) & 1;
+		}
+		return *this;
 	}
-	else {
-		if (b.numbers.size() > a.numbers.size()) return false;
-		if (b.numbers.size() < a.numbers.size()) return true;
+	constexpr FixedInteger& operator*=(const FixedInteger& x) {
+		FixedInteger result;
+		for (size_t i = 0; i < WORDS; ++i) {
+			uint64_t carry = 0;
+			for (size_t j = 0; i + j < WORDS; ++j) {
+				unsigned __int128 cur = static_cast<unsigned __int128>(words[i]) * x.words[j] + result.words[i + j] + carry;
+				result.words[i + j] = static_cast<uint64_t>(cur);
+				carry = static_cast<uint64_t>(cur >> 64);
+			}
+		}
+		return *this = result;
 	}
+	constexpr FixedInteger operator-() const {
+		return FixedInteger() -= *this;
+	}
+
+	friend constexpr FixedInteger operator+(FixedInteger a, const FixedInteger& b) { return a += b; }
+	friend constexpr FixedInteger operator-(FixedInteger a, const FixedInteger& b) { return a -= b; }
+	friend constexpr FixedInteger operator*(FixedInteger a, const FixedInteger& b) { return a *= b; }
 
-	for (size_t i = a.numbers.size(); i > 0; --i) {
-		if (a.sign) {
-			if (a.numbers[i - 1] > b.numbers[i - 1]) return false;
-			if (a.numbers[i - 1] < b.numbers[i - 1]) return true;
+	friend constexpr bool operator==(const FixedInteger& a, const FixedInteger& b) {
+		for (size_t i = 0; i < WORDS; ++i) {
+			if (a.words[i] != b.words[i]) return false;
 		}
-		else {
-			if (a.numbers[i - 1] < b.numbers[i - 1]) return false;
-			if (a.numbers[i - 1] > b.numbers[i - 1]) return true;
+		return true;
+	}
+	friend constexpr bool operator<(const FixedInteger& a, const FixedInteger& b) {
+		for (size_t i = WORDS; i > 0; --i) {
+			if (a.words[i - 1] != b.words[i - 1]) return a.words[i - 1] < b.words[i - 1];
 		}
+		return false;
 	}
-	return false;
-}
-bool operator>(const BigInteger& a, const BigInteger& b) {
-	return b < a;
+	friend constexpr bool operator!=(const FixedInteger& a, const FixedInteger& b) { return !(a == b); }
+	friend constexpr bool operator>(const FixedInteger& a, const FixedInteger& b) { return b < a; }
+	friend constexpr bool operator<=(const FixedInteger& a, const FixedInteger& b) { return !(b < a); }
+	friend constexpr bool operator>=(const FixedInteger& a, const FixedInteger& b) { return !(a < b); }
+
+	string toString() const { return static_cast<BigInteger>(*this).toString(); }
+
+private:
+	uint64_t words[WORDS];
+};
+
+template <size_t Bits>
+FixedInteger<Bits>::FixedInteger(const BigInteger& x) : words{} {
+	for (size_t i = x.numbers.size(); i > 0; --i) {
+		*this *= FixedInteger(BigInteger::BASE);
+		*this += FixedInteger(x.numbers[i - 1]);
+	}
+	if (x < 0) *this = -*this;
 }
-bool operator!=(const BigInteger& a, const BigInteger& b) {
-	return !(a == b);
+template <size_t Bits>
+FixedInteger<Bits>::operator BigInteger() const {
+	BigInteger result;
+	for (size_t i = WORDS; i > 0; --i) {
+		result *= uint64_t(1) << 32;
+		result *= uint64_t(1) << 32;
+		result += words[i - 1];
+	}
+	return result;
 }
-bool operator<=(const BigInteger& a, const BigInteger& b) {
-	return !(a > b);
+
+// Decimal constant laid out as base 1e9 limbs at compile time; see _bi.
+template <size_t Limbs>
+struct BigIntegerLiteral {
+	uint32_t limbs[Limbs];
+	bool negative;
+
+	constexpr BigIntegerLiteral operator-() const {
+		BigIntegerLiteral result = *this;
+		result.negative = !negative;
+		return result;
+	}
+	operator BigInteger() const {
+		BigInteger result = BigInteger::from_limbs(limbs, limbs + Limbs);
+		if (negative && result != 0) result.sign = false;
+		return result;
+	}
+	template <size_t Bits>
+	constexpr operator FixedInteger<Bits>() const {
+		FixedInteger<Bits> result;
+		for (size_t i = Limbs; i > 0; --i) {
+			result *= FixedInteger<Bits>(BigInteger::BASE);
+			result += FixedInteger<Bits>(limbs[i - 1]);
+		}
+		return negative ? -result : result;
+	}
+};
+
+template <char... Digits>
+constexpr BigIntegerLiteral<((Digits != '\'') + ... + 8) / 9> parse_big_integer_literal() {
+	constexpr char text[] = {Digits...};
+	BigIntegerLiteral<((Digits != '\'') + ... + 8) / 9> result{};
+	size_t position = 0;
+	for (size_t i = sizeof(text); i > 0; --i) {
+		char c = text[i - 1];
+		if (c == '\'') continue;
+		if (c < '0' || c > '9') throw std::domain_error("_bi takes decimal digits only");
+		uint32_t scale = 1;
+		for (size_t j = 0; j < position % 9; ++j) scale *= 10;
+		result.limbs[position / 9] += (c - '0') * scale;
+		++position;
+	}
+	// 0123 is an octal literal in C++, so _bi refuses it rather than read it as decimal.
+	if (text[0] == '0' && position > 1) throw std::domain_error("_bi takes no leading zero");
+	return result;
 }
-bool operator>=(const BigInteger& a, const BigInteger& b) {
-	return !(a < b);
+// A variable template forces the parse to happen during compilation.
+template <char... Digits>
+constexpr auto big_integer_literal = parse_big_integer_literal<Digits...>();
+
+template <char... Digits>
+constexpr auto operator""_bi() {
+	return big_integer_literal<Digits...>;
 }
 
-BigInteger::operator bool() {
-	return *this != BigInteger(0);
+
+class Modulus {
+public:
+	explicit Modulus(const BigInteger& modulus);
+
+	const BigInteger& value() const;
+	BigInteger reduce(const BigInteger& x) const;
+	BigInteger mulmod(const BigInteger& a, const BigInteger& b) const;
+	BigInteger powmod(const BigInteger& base, const BigInteger& exponent) const;
+	BigInteger invmod(const BigInteger& x) const;
+
+private:
+	BigInteger modulus;
+	LimbVector reciprocal;
+
+	void reduce_abs(LimbVector& x) const;
+};
+
+Modulus::Modulus(const BigInteger& modulus) : modulus(modulus) {
+	if (!modulus.sign || (modulus.numbers.size() == 1 && modulus.numbers[0] == 0)) {
+		throw std::domain_error("modulus must be positive");
+	}
+	LimbVector power(2 * modulus.numbers.size() + 1, 0);
+	power.back() = 1;
+	LimbVector remainder;
+	BigInteger::divide_abs(power, modulus.numbers, reciprocal, remainder);
 }
-string BigInteger::toString() const {
-	string s;
-	if (!sign) s += '-';
-	for (size_t i = numbers.size(); i >= 1; --i) {
-		s += numbers[i - 1] + '0';
+const BigInteger& Modulus::value() const {
+	return modulus;
+}
+// Barrett reduction for x < B^2k, k = size of modulus; at most two corrections.
+void Modulus::reduce_abs(LimbVector& x) const {
+	const LimbVector& m = modulus.numbers;
+	size_t k = m.size();
+	if (BigInteger::compare_limbs(x, m) < 0) return;
+	LimbVector estimate = BigInteger::multiply_abs(LimbVector(x.begin() + (k - 1), x.end()), reciprocal);
+	if (estimate.size() > k + 1) {
+		estimate.erase(estimate.begin(), estimate.begin() + (k + 1));
+		BigInteger::subtract_abs(x, BigInteger::multiply_abs(estimate, m));
+	}
+	while (BigInteger::compare_limbs(x, m) >= 0) {
+		BigInteger::subtract_abs(x, m);
 	}
-	return s;
 }
-
-std::ostream& operator<<(std::ostream& out, const BigInteger& x) {
-	out << x.toString();
-	return out;
+BigInteger Modulus::reduce(const BigInteger& x) const {
+	BigInteger result;
+	if (x.numbers.size() <= 2 * modulus.numbers.size()) {
+		result.numbers = x.numbers;
+		reduce_abs(result.numbers);
+	}
+	else {
+		LimbVector quotient;
+		BigInteger::divide_abs(x.numbers, modulus.numbers, quotient, result.numbers);
+	}
+	result.norm();
+	if (!x.sign && result) result = modulus - result;
+	return result;
 }
-std::istream& operator>>(std::istream& in, BigInteger& x) {
-	string s;
-	in >> s;
-	x.sign = true;
-	x.numbers.clear();
-	if (s.size() > 0 && s[0] == '-') x.sign = false;
-	for (size_t i = s.size(); i >= 1; --i) {
-		if (s[i - 1] != '-')
+BigInteger Modulus::mulmod(const BigInteger& a, const BigInteger& b) const {
+	BigInteger x = reduce(a);
+	if (&a == &b) return reduce(x * x);
+	return reduce(x * reduce(b));
+}
+BigInteger Modulus::powmod(const BigInteger& base, const BigInteger& exponent) const {
+	BigInteger rest = exponent;
+	rest.sign = true;
+	vector<bool> bits;
+	while (rest) {
+		uint32_t chunk = rest.divide_small(1u << 29);
+		for (int i = 0; i < 29; ++i) {
+			bits.push_back((chunk >> i) & 1);
+		}
+	}
+	while (!bits.empty() && !bits.back()) {
+		bits.pop_back();
+	}
 
-			x.numbers.push_back(s[i - 1] - '0');
+	size_t window = bits.size() > 671 ? 6 : bits.size() > 239 ? 5 : bits.size() > 79 ? 4 : bits.size() > 23 ? 3 : 1;
+	vector<BigInteger> odd_powers(size_t(1) << (window - 1));
+	odd_powers[0] = exponent.sign ? reduce(base) : invmod(base);
+	if (odd_powers.size() > 1) {
+		BigInteger square = mulmod(odd_powers[0], odd_powers[0]);
+		for (size_t i = 1; i < odd_powers.size(); ++i) {
+			odd_powers[i] = mulmod(odd_powers[i - 1], square);
+		}
 	}
-	x.norm();
-	return in;
 
-	/*x = 0;
-	x.sign = s.size() > 0 && s[0] != '-';
-	for (size_t i = 0; i < s.size() / 2; ++i) {
-		swap(s[i], s[s.size() - 1 - i]);
+	BigInteger result = reduce(1);
+	for (size_t i = bits.size(); i > 0;) {
+		if (!bits[i - 1]) {
+			result = mulmod(result, result);
+			--i;
+			continue;
+		}
+		size_t low = i > window ? i - window : 0;
+		while (!bits[low]) {
+			++low;
+		}
+		size_t digit = 0;
+		for (size_t j = i; j > low;) {
+			--j;
+			result = mulmod(result, result);
+			digit = 2 * digit + bits[j];
+		}
+		result = mulmod(result, odd_powers[digit >> 1]);
+		i = low;
 	}
-	while (s.size() > 1 && s.back() == '0') {
-		s.pop_back();
+	return result;
+}
+BigInteger Modulus::invmod(const BigInteger& x) const {
+	BigInteger a = modulus, b = reduce(x), u = 0, v = 1;
+	while (b) {
+		pair<BigInteger, BigInteger> step = divmod(a, b);
+		a = std::move(b);
+		b = std::move(step.second);
+		u -= step.first * v;
+		std::swap(u, v);
 	}
-	x.numbers = vector<short>(0);
-	size_t power = 1;
-	for (size_t i = 0; i < s.size() && s[i] != '-'; ++i) {
-		x.numbers.push_back((static_cast<int>(s[i]) - 48));
+	if (a != 1) {
+		throw std::domain_error("value is not invertible");
 	}
-	x.norm();
-	return in;*/
+	return reduce(u);
 }
 
 
 class Rational {
 public:
+	static bool lazy_normalization;
+	static size_t lazy_limit;
+
 	Rational();
 	Rational(int x);
 	Rational(const BigInteger& x);
@@ -360,18 +2610,74 @@ public:
 	Rational& operator*=(const Rational& x);
 	Rational& operator/=(const Rational& x);
 
+	// Both add every term over a common denominator built as a tree of
+	// pairwise LCMs and reduce the result once.
+	template <class Range>
+	static Rational sum(const Range& values);
+	template <class Range, class OtherRange>
+	static Rational dot(const Range& a, const OtherRange& b);
+
 	string toString() const;
 	string asDecimal(size_t precision) const;
+	void asDecimal(std::ostream& out, size_t precision) const;
 	explicit operator double();
 
 private:
-	BigInteger numerator;
-	BigInteger denominator;
-
-	void norm();
+	mutable BigInteger numerator;
+	mutable BigInteger denominator;
+	mutable bool reduced = true;
+	// When is_small is set the value lives here instead and the BigInteger
+	// fields are stale. The int64 fast paths keep any reduced result with
+	// both parts in (INT64_MIN, INT64_MAX]; demote() only moves back values
+	// of at most WORD_LIMBS limbs (below 10^18).
+	mutable int64_t small_numerator = 0;
+	mutable int64_t small_denominator = 1;
+	mutable bool is_small = true;
+
+	void norm() const;
+	void observe() const;
+	void promote() const;
+	void demote() const;
+	void assign_wide(__int128 x_numerator, __int128 x_denominator);
+	static BigInteger from_wide(__int128 x);
+	void update();
+	void cross_multiply(const BigInteger& x_numerator, const BigInteger& x_denominator);
+
+	// Read-only BigInteger form of a value: small values are widened into the
+	// view, so reading a const operand never switches it out of small mode.
+	struct Wide {
+		explicit Wide(const Rational& x);
+		Wide(const Wide&) = delete;
+		Wide& operator=(const Wide&) = delete;
+
+		BigInteger widened_numerator;
+		BigInteger widened_denominator;
+		const BigInteger& numerator;
+		const BigInteger& denominator;
+	};
+
+	using Fraction = pair<BigInteger, BigInteger>;
+	Fraction parts() const;
+	size_t limbs() const;
+	static void add_fraction(Fraction& x, const Fraction& y);
+	static Rational sum_fractions(vector<Fraction>& terms);
+
+	static constexpr size_t DECIMAL_BLOCK = 16;
+	// Limbs of the shorter part that operator double keeps; at least 64 bits.
+	static constexpr size_t DOUBLE_LIMBS = 4;
+	template <class Sink>
+	void write_decimal(Sink sink, size_t precision) const;
+	static double log2_abs(const BigInteger& x);
+	static int compare(const Rational& a, const Rational& b);
 
 	friend bool operator==(const Rational& a, const Rational& b);
 	friend bool operator<=(const Rational& a, const Rational& b);
+	friend bool operator<(const Rational& a, const Rational& b);
+#if __cplusplus >= 202002L
+	friend std::strong_ordering operator<=>(const Rational& a, const Rational& b);
+#endif
+	friend struct BinaryFormat;
+	friend void writeBinary(std::ostream& out, const vector<Rational>& values);
 };
 
 Rational operator+(const Rational& a, const Rational& b);
@@ -379,65 +2685,206 @@ Rational operator-(const Rational& a, const Rational& b);
 Rational operator*(const Rational& a, const Rational& b);
 Rational operator/(const Rational& a, const Rational& b);
 
+Rational operator+(Rational&& a, const Rational& b);
+Rational operator-(Rational&& a, const Rational& b);
+Rational operator*(Rational&& a, const Rational& b);
+Rational operator/(Rational&& a, const Rational& b);
+
 bool operator==(const Rational& a, const Rational& b);
 bool operator!=(const Rational& a, const Rational& b);
 bool operator<=(const Rational& a, const Rational& b);
 bool operator>=(const Rational& a, const Rational& b);
 bool operator<(const Rational& a, const Rational& b);
 bool operator>(const Rational& a, const Rational& b);
+#if __cplusplus >= 202002L
+std::strong_ordering operator<=>(const Rational& a, const Rational& b);
+#endif
 
 std::ostream& operator<<(std::ostream& out, const Rational& x);
 
 Rational::Rational() : numerator(0), denominator(1) {};
-Rational::Rational(int x) : numerator(x), denominator(1) {};
-Rational::Rational(const BigInteger& x) : numerator(x), denominator(1) {};
-
-void Rational::norm() {
-	BigInteger a = numerator;
-	BigInteger b = denominator;
-	if (a < 0) a *= -1;
-	if (b < 0) b *= -1;
-	while (b) {
-		a %= b;
-		std::swap(a, b);
+Rational::Rational(int x) : numerator(0), denominator(1), small_numerator(x) {};
+Rational::Rational(const BigInteger& x) : numerator(x), denominator(1), is_small(false) {
+	demote();
+};
+
+bool Rational::lazy_normalization = false;
+size_t Rational::lazy_limit = 2000;
+
+void Rational::norm() const {
+	reduced = true;
+	BigInteger divisor = gcd(numerator, denominator);
+	if (denominator < 0) divisor = -divisor;
+	if (divisor != 1) {
+		numerator = divexact(numerator, divisor);
+		denominator = divexact(denominator, divisor);
 	}
-	if (denominator < 0) a *= -1;
-	numerator /= a;
-	denominator /= a;
+	demote();
+}
+void Rational::observe() const {
+	if (!is_small && !reduced) norm();
+}
+Rational::Wide::Wide(const Rational& x)
+	: widened_numerator(x.is_small ? from_wide(x.small_numerator) : BigInteger()),
+	  widened_denominator(x.is_small ? from_wide(x.small_denominator) : BigInteger()),
+	  numerator(x.is_small ? widened_numerator : x.numerator),
+	  denominator(x.is_small ? widened_denominator : x.denominator) {}
+void Rational::promote() const {
+	if (!is_small) return;
+	numerator = from_wide(small_numerator);
+	denominator = from_wide(small_denominator);
+	is_small = false;
+}
+void Rational::demote() const {
+	if (!reduced || numerator.numbers.size() > BigInteger::WORD_LIMBS || denominator.numbers.size() > BigInteger::WORD_LIMBS) return;
+	small_numerator = numerator.to_word();
+	small_denominator = denominator.to_word();
+	is_small = true;
+}
+void Rational::assign_wide(__int128 x_numerator, __int128 x_denominator) {
+	const __int128 limit = std::numeric_limits<int64_t>::max();
+	reduced = true;
+	if (-limit <= x_numerator && x_numerator <= limit && x_denominator <= limit) {
+		small_numerator = static_cast<int64_t>(x_numerator);
+		small_denominator = static_cast<int64_t>(x_denominator);
+		is_small = true;
+		return;
+	}
+	numerator = from_wide(x_numerator);
+	denominator = from_wide(x_denominator);
+	is_small = false;
+}
+BigInteger Rational::from_wide(__int128 x) {
+	BigInteger result;
+	result.sign = x >= 0;
+	unsigned __int128 value = x < 0 ? -static_cast<unsigned __int128>(x) : x;
+	result.numbers.clear();
+	while (value > 0) {
+		result.numbers.push_back(static_cast<uint32_t>(value % BigInteger::BASE));
+		value /= BigInteger::BASE;
+	}
+	result.norm();
+	return result;
+}
+void Rational::update() {
+	if (!lazy_normalization || numerator.charsLength() > lazy_limit || denominator.charsLength() > lazy_limit) {
+		norm();
+		return;
+	}
+	if (denominator < 0) {
+		numerator = -numerator;
+		denominator = -denominator;
+	}
+	reduced = false;
+}
+void Rational::cross_multiply(const BigInteger& x_numerator, const BigInteger& x_denominator) {
+	if (numerator == 0 || x_numerator == 0) {
+		*this = 0;
+		return;
+	}
+	BigInteger first = gcd(numerator, x_denominator);
+	BigInteger second = gcd(x_numerator, denominator);
+	if (first != 1) numerator = divexact(numerator, first);
+	if (second != 1) denominator = divexact(denominator, second);
+	if (second == 1) numerator *= x_numerator;
+	else numerator *= divexact(x_numerator, second);
+	if (first == 1) denominator *= x_denominator;
+	else denominator *= divexact(x_denominator, first);
+	if (denominator < 0) {
+		numerator = -numerator;
+		denominator = -denominator;
+	}
+	demote();
 }
 
 Rational Rational::operator-() const {
 	Rational x = *this;
-	x.numerator *= -1;
-	x.norm();
+	if (is_small) x.small_numerator = -x.small_numerator;
+	else x.numerator = -x.numerator;
 	return x;
 }
 
 Rational& Rational::operator+=(const Rational& x) {
-	numerator = numerator * x.denominator + x.numerator * denominator;
-	denominator *= x.denominator;
-	norm();
+	if (this == &x) return *this *= 2;
+	if (is_small && x.is_small) {
+		int64_t divisor = std::gcd(small_denominator, x.small_denominator);
+		__int128 sum = static_cast<__int128>(small_numerator) * (x.small_denominator / divisor)
+			+ static_cast<__int128>(x.small_numerator) * (small_denominator / divisor);
+		if (sum == 0) return *this = 0;
+		int64_t common = std::gcd(static_cast<int64_t>(sum % divisor), divisor);
+		assign_wide(sum / common, static_cast<__int128>(small_denominator / divisor) * (x.small_denominator / common));
+		return *this;
+	}
+	promote();
+	Wide y(x);
+	numerator *= y.denominator;
+	numerator += mul(y.numerator, denominator);
+	denominator *= y.denominator;
+	update();
 	return *this;
 }
 
 Rational& Rational::operator-=(const Rational& x) {
-	numerator = numerator * x.denominator - x.numerator * denominator;
+	if (this == &x) return *this = 0;
+	if (x.is_small) return *this += -x;
+	promote();
+	numerator *= x.denominator;
+	numerator -= mul(x.numerator, denominator);
 	denominator *= x.denominator;
-	norm();
+	update();
 	return *this;
 }
 
 Rational& Rational::operator*=(const Rational& x) {
-	numerator *= x.numerator;
-	denominator *= x.denominator;
-	norm();
+	if (is_small && x.is_small) {
+		if (small_numerator == 0 || x.small_numerator == 0) return *this = 0;
+		int64_t first = std::gcd(small_numerator, x.small_denominator);
+		int64_t second = std::gcd(x.small_numerator, small_denominator);
+		assign_wide(static_cast<__int128>(small_numerator / first) * (x.small_numerator / second),
+			static_cast<__int128>(small_denominator / second) * (x.small_denominator / first));
+		return *this;
+	}
+	promote();
+	if (this == &x) {
+		numerator *= numerator;
+		denominator *= denominator;
+		return *this;
+	}
+	Wide y(x);
+	if (reduced && x.reduced) {
+		cross_multiply(y.numerator, y.denominator);
+		return *this;
+	}
+	numerator *= y.numerator;
+	denominator *= y.denominator;
+	update();
 	return *this;
 }
 
 Rational& Rational::operator/=(const Rational& x) {
-	numerator *= x.denominator;
-	denominator *= x.numerator;
-	norm();
+	if (this == &x) return *this = 1;
+	if (is_small && x.is_small && x.small_numerator != 0) {
+		if (small_numerator == 0) return *this;
+		int64_t first = std::gcd(small_numerator, x.small_numerator);
+		int64_t second = std::gcd(x.small_denominator, small_denominator);
+		__int128 result_numerator = static_cast<__int128>(small_numerator / first) * (x.small_denominator / second);
+		__int128 result_denominator = static_cast<__int128>(small_denominator / second) * (x.small_numerator / first);
+		if (result_denominator < 0) {
+			result_numerator = -result_numerator;
+			result_denominator = -result_denominator;
+		}
+		assign_wide(result_numerator, result_denominator);
+		return *this;
+	}
+	promote();
+	Wide y(x);
+	if (reduced && x.reduced) {
+		cross_multiply(y.denominator, y.numerator);
+		return *this;
+	}
+	numerator *= y.denominator;
+	denominator *= y.numerator;
+	update();
 	return *this;
 }
 
@@ -465,16 +2912,152 @@ Rational operator/(const Rational& a, const Rational& b) {
 	return result;
 }
 
+Rational operator+(Rational&& a, const Rational& b) {
+	a += b;
+	return std::move(a);
+}
+
+Rational operator-(Rational&& a, const Rational& b) {
+	a -= b;
+	return std::move(a);
+}
+
+Rational operator*(Rational&& a, const Rational& b) {
+	a *= b;
+	return std::move(a);
+}
+
+Rational operator/(Rational&& a, const Rational& b) {
+	a /= b;
+	return std::move(a);
+}
+
 bool operator==(const Rational& a, const Rational& b) {
-	return a.numerator == b.numerator && a.denominator == b.denominator;
+	if (a.is_small && b.is_small) {
+		return a.small_numerator == b.small_numerator && a.small_denominator == b.small_denominator;
+	}
+	a.observe();
+	b.observe();
+	Rational::Wide x(a), y(b);
+	return x.numerator == y.numerator && x.denominator == y.denominator;
 }
 
 bool operator!=(const Rational& a, const Rational& b) {
 	return !(a == b);
 }
 
+// Reads the value without promoting, so callers may share operands across
+// threads; lazily normalized values come back unreduced.
+Rational::Fraction Rational::parts() const {
+	if (is_small) return {from_wide(small_numerator), from_wide(small_denominator)};
+	return {numerator, denominator};
+}
+size_t Rational::limbs() const {
+	return is_small ? 2 * BigInteger::WORD_LIMBS : numerator.numbers.size() + denominator.numbers.size();
+}
+void Rational::add_fraction(Fraction& x, const Fraction& y) {
+	if (x.second == y.second) {
+		x.first += y.first;
+		return;
+	}
+	BigInteger divisor = gcd(x.second, y.second);
+	if (divisor == 1) {
+		x.first *= y.second;
+		x.first += mul(y.first, x.second);
+		x.second *= y.second;
+		return;
+	}
+	BigInteger y_factor = divexact(y.second, divisor);
+	x.first *= y_factor;
+	x.first += mul(y.first, divexact(x.second, divisor));
+	x.second *= y_factor;
+}
+Rational Rational::sum_fractions(vector<Fraction>& terms) {
+	if (terms.empty()) return 0;
+	while (terms.size() > 1) {
+		size_t work = 0;
+		for (const Fraction& x : terms) {
+			work += x.first.numbers.size() + x.second.numbers.size();
+		}
+		vector<Fraction> next((terms.size() + 1) / 2);
+		BigInteger::parallel_for(next.size(), work, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				next[i] = std::move(terms[2 * i]);
+				if (2 * i + 1 < terms.size()) add_fraction(next[i], terms[2 * i + 1]);
+			}
+		});
+		terms.swap(next);
+	}
+	Rational result;
+	result.numerator = std::move(terms[0].first);
+	result.denominator = std::move(terms[0].second);
+	result.is_small = false;
+	result.update();
+	return result;
+}
+template <class Range>
+Rational Rational::sum(const Range& values) {
+	vector<Fraction> terms;
+	for (const Rational& x : values) {
+		terms.push_back(x.parts());
+	}
+	return sum_fractions(terms);
+}
+template <class Range, class OtherRange>
+Rational Rational::dot(const Range& a, const OtherRange& b) {
+	vector<pair<const Rational*, const Rational*>> factors;
+	auto other = std::begin(b);
+	for (const Rational& x : a) {
+		if (other == std::end(b)) throw std::domain_error("dot product of ranges of different lengths");
+		factors.emplace_back(&x, &*other++);
+	}
+	if (other != std::end(b)) throw std::domain_error("dot product of ranges of different lengths");
+	size_t work = 0;
+	for (const auto& factor : factors) {
+		work += factor.first->limbs() + factor.second->limbs();
+	}
+	vector<Fraction> terms(factors.size());
+	BigInteger::parallel_for(factors.size(), work, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			const Rational& x = *factors[i].first;
+			const Rational& y = *factors[i].second;
+			if (x.is_small && y.is_small) {
+				terms[i].first = from_wide(static_cast<__int128>(x.small_numerator) * y.small_numerator);
+				terms[i].second = from_wide(static_cast<__int128>(x.small_denominator) * y.small_denominator);
+				continue;
+			}
+			Fraction left = x.parts(), right = y.parts();
+			terms[i].first = left.first * right.first;
+			terms[i].second = left.second * right.second;
+		}
+	});
+	return sum_fractions(terms);
+}
+
+int Rational::compare(const Rational& a, const Rational& b) {
+	if (a.is_small && b.is_small) {
+		__int128 left = static_cast<__int128>(a.small_numerator) * b.small_denominator;
+		__int128 right = static_cast<__int128>(b.small_numerator) * a.small_denominator;
+		return left < right ? -1 : left > right;
+	}
+	a.observe();
+	b.observe();
+	Wide x(a), y(b);
+	int a_sign = x.numerator.sign ? static_cast<bool>(x.numerator) : -1;
+	int b_sign = y.numerator.sign ? static_cast<bool>(y.numerator) : -1;
+	if (a_sign != b_sign || a_sign == 0) return a_sign < b_sign ? -1 : a_sign > b_sign;
+	if (x.denominator == 1 && y.denominator == 1) return BigInteger::compare(x.numerator, y.numerator);
+	// Each log2_abs is off by well under 1e-8 bits plus rounding, so a wider
+	// gap settles the order without forming either product.
+	double logs[4] = {log2_abs(x.numerator), log2_abs(x.denominator), log2_abs(y.numerator), log2_abs(y.denominator)};
+	double gap = (logs[0] - logs[1]) - (logs[2] - logs[3]);
+	double margin = 1e-6 + 1e-12 * (logs[0] + logs[1] + logs[2] + logs[3]);
+	if (fabs(gap) > margin) return (gap < 0) == (a_sign > 0) ? -1 : 1;
+	return BigInteger::compare(x.numerator * y.denominator, y.numerator * x.denominator);
+}
+
 bool operator<=(const Rational& a, const Rational& b) {
-	return a.numerator * b.denominator <= b.numerator * a.denominator;
+	return Rational::compare(a, b) <= 0;
 }
 
 bool operator>=(const Rational& a, const Rational& b) {
@@ -482,70 +3065,397 @@ bool operator>=(const Rational& a, const Rational& b) {
 }
 
 bool operator<(const Rational& a, const Rational& b) {
-	return a <= b && a != b;
+	return Rational::compare(a, b) < 0;
 }
 
 bool operator>(const Rational& a, const Rational& b) {
 	return b < a;
 }
 
+#if __cplusplus >= 202002L
+std::strong_ordering operator<=>(const Rational& a, const Rational& b) {
+	return Rational::compare(a, b) <=> 0;
+}
+#endif
+
 string Rational::toString() const {
+	if (is_small) {
+		string result = std::to_string(small_numerator);
+		if (small_denominator != 1) result += '/' + std::to_string(small_denominator);
+		return result;
+	}
+	observe();
 	string result = numerator.toString();
 	if (denominator != 1) result += '/' + denominator.toString();
 	return result;
 }
-string Rational::asDecimal(size_t precision = 0) const {
-	string temp_help;
-	BigInteger power = 1;
-	for (size_t i = 0; i < precision; ++i) {
-		power *= 10;
+template <class Sink>
+void Rational::write_decimal(Sink sink, size_t precision) const {
+	Wide value(*this);
+	if (value.numerator < 0) sink("-", 1);
+	pair<BigInteger, BigInteger> step = divmod(value.numerator < 0 ? -value.numerator : value.numerator, value.denominator);
+	string whole = step.first.toString();
+	sink(whole.data(), whole.size());
+	if (precision == 0) return;
+	sink(".", 1);
+
+	BigInteger rest = std::move(step.second);
+	size_t block = max(value.denominator.numbers.size(), DECIMAL_BLOCK);
+	string chunk;
+	while (precision > 0) {
+		size_t limbs = min(block, (precision + BigInteger::BASE_DIGITS - 1) / BigInteger::BASE_DIGITS);
+		rest.multiply_power_of_ten(limbs * BigInteger::BASE_DIGITS);
+		step = divmod(rest, value.denominator);
+		chunk.assign(limbs * BigInteger::BASE_DIGITS, '0');
+		step.first.toChars(&chunk[chunk.size() - step.first.charsLength()]);
+		size_t count = min(precision, chunk.size());
+		sink(chunk.data(), count);
+		precision -= count;
+		rest = std::move(step.second);
 	}
-	temp_help = (numerator * power / denominator).toString();
+}
+string Rational::asDecimal(size_t precision = 0) const {
 	string result;
-	for (size_t i = 0; i <= precision || i < temp_help.size(); ++i) {
+	write_decimal([&result](const char* data, size_t length) { result.append(data, length); }, precision);
+	return result;
+}
+void Rational::asDecimal(std::ostream& out, size_t precision) const {
+	write_decimal([&out](const char* data, size_t length) { out.write(data, length); }, precision);
+}
 
-		if (i < temp_help.size()) {
-			if (temp_help[temp_help.size() - 1 - i] != '-')
-				result += temp_help[temp_help.size() - 1 - i];
-			else result += '0';
-		}
-		else {
-			result += '0';
+double Rational::log2_abs(const BigInteger& x) {
+	const LimbVector& limbs = x.numbers;
+	double top = limbs.back();
+	if (limbs.size() > 1) top += limbs[limbs.size() - 2] / static_cast<double>(BigInteger::BASE);
+	return log2(top) + (limbs.size() - 1) * log2(static_cast<double>(BigInteger::BASE));
+}
+Rational::operator double() {
+	const int64_t exact_small = int64_t(1) << 53;
+	if (is_small && -exact_small <= small_numerator && small_numerator <= exact_small && small_denominator <= exact_small) {
+		return static_cast<double>(small_numerator) / static_cast<double>(small_denominator);
+	}
+	observe();
+	Wide value(*this);
+	if (value.numerator == 0) return 0;
+	double sign = value.numerator < 0 ? -1 : 1;
+	const uint64_t exact_limit = uint64_t(1) << 53;
+	if (value.numerator.numbers.size() <= BigInteger::WORD_LIMBS && value.denominator.numbers.size() <= BigInteger::WORD_LIMBS) {
+		int64_t word = value.numerator.to_word();
+		uint64_t a = word < 0 ? 0 - static_cast<uint64_t>(word) : static_cast<uint64_t>(word);
+		uint64_t b = static_cast<uint64_t>(value.denominator.to_word());
+		if (a <= exact_limit && b <= exact_limit) return sign * static_cast<double>(a) / static_cast<double>(b);
+	}
+
+	double estimate = log2_abs(value.numerator) - log2_abs(value.denominator);
+	if (estimate > 1025) return sign * HUGE_VAL;
+	if (estimate < -1080) return sign * 0.0;
+	int shift = 57 - static_cast<int>(floor(estimate));
+	// Both parts drop the same number of low limbs, leaving the shorter one
+	// DOUBLE_LIMBS long, so the quotient of what is left is within 2^-29 of
+	// the exact ~58-bit one. Only a quotient next to a rounding midpoint
+	// has to be redone in full.
+	const LimbVector& top_numerator = value.numerator.numbers;
+	const LimbVector& top_denominator = value.denominator.numbers;
+	size_t shorter = min(top_numerator.size(), top_denominator.size());
+	size_t cut = shorter > DOUBLE_LIMBS ? shorter - DOUBLE_LIMBS : 0;
+	while (true) {
+		BigInteger a = BigInteger::from_limbs(top_numerator.begin() + cut, top_numerator.end());
+		BigInteger b = BigInteger::from_limbs(top_denominator.begin() + cut, top_denominator.end());
+		BigInteger& scaled = shift > 0 ? a : b;
+		scaled *= pow(BigInteger(2), shift > 0 ? shift : -shift);
+		pair<BigInteger, BigInteger> step = divmod(a, b);
+		uint64_t quotient = static_cast<uint64_t>(step.first.to_word());
+		bool sticky = step.second != 0;
+
+		int bits = 64 - __builtin_clzll(quotient);
+		int exponent = bits - 1 - shift;
+		int precision = exponent < -1022 ? 53 - (-1022 - exponent) : 53;
+		int drop = bits - precision;
+		if (drop > bits) return sign * 0.0;
+		uint64_t mantissa = quotient >> drop;
+		uint64_t rest = quotient & ((uint64_t(1) << drop) - 1);
+		uint64_t half = uint64_t(1) << (drop - 1);
+		if (cut > 0 && (rest == half || rest + 1 == half)) {
+			cut = 0;
+			continue;
 		}
-		if (i + 1 == precision) {
-			result += '.';
+		if (rest > half || (rest == half && (sticky || (mantissa & 1)))) ++mantissa;
+		return sign * ldexp(static_cast<double>(mantissa), drop - shift);
+	}
+}
+
+std::ostream& operator<<(std::ostream& out, const Rational& x) {
+	out << x.toString();
+	return out;
+}
+
+
+// Binary format (little-endian): a Header followed by count records, two per
+// value (numerator, denominator) for rationals. A record is a Record header
+// and then its base 1e9 limbs, least significant first.
+struct BinaryFormat {
+	static constexpr char MAGIC[4] = {'B', 'G', 'N', 'M'};
+	static constexpr uint16_t VERSION = 1;
+	static constexpr uint16_t INTEGERS = 0;
+	static constexpr uint16_t RATIONALS = 1;
+	static constexpr uint32_t NEGATIVE = 1;
+	// Record lengths are untrusted, so streams are read at most this many
+	// limbs (256 KiB) ahead of the data that has actually arrived.
+	static constexpr size_t READ_CHUNK_LIMBS = size_t(1) << 16;
+#ifdef __BYTE_ORDER__
+	static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the binary format is written in native byte order");
+#endif
+
+	struct Header {
+		char magic[4];
+		uint16_t version;
+		uint16_t kind;
+		uint64_t count;
+	};
+	struct Record {
+		uint32_t length;
+		uint32_t flags;
+	};
+
+	static void write_header(std::ostream& out, uint16_t kind, uint64_t count);
+	static uint64_t read_header(std::istream& in, uint16_t kind);
+	static void write_record(std::ostream& out, const BigInteger& x);
+	static void read_record(std::istream& in, BigInteger& x);
+	static bool valid_limbs(const uint32_t* limbs, size_t length);
+	static BigInteger from_limbs(const uint32_t* limbs, size_t length, bool negative);
+	static Rational from_parts(BigInteger numerator, BigInteger denominator);
+};
+
+class BigIntegerView {
+public:
+	BigIntegerView(const uint32_t* limbs, size_t length, bool negative);
+
+	size_t size() const;
+	bool negative() const;
+	const uint32_t* data() const;
+	BigInteger toBigInteger() const;
+
+private:
+	const uint32_t* limbs;
+	size_t length;
+	bool is_negative;
+};
+
+struct RationalView {
+	BigIntegerView numerator;
+	BigIntegerView denominator;
+
+	Rational toRational() const;
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+class MappedNumbers {
+public:
+	explicit MappedNumbers(const string& path);
+	MappedNumbers(const MappedNumbers&) = delete;
+	MappedNumbers& operator=(const MappedNumbers&) = delete;
+	~MappedNumbers();
+
+	size_t size() const;
+	bool holdsRationals() const;
+	BigIntegerView operator[](size_t index) const;
+	RationalView rational(size_t index) const;
+
+private:
+	const char* address = nullptr;
+	size_t length = 0;
+	bool rationals = false;
+	vector<const BinaryFormat::Record*> records;
+
+	BigIntegerView view(size_t record) const;
+	void fail(const char* message);
+};
+#endif
+
+void writeBinary(std::ostream& out, const vector<BigInteger>& values);
+void writeBinary(std::ostream& out, const vector<Rational>& values);
+void readBinary(std::istream& in, vector<BigInteger>& values);
+void readBinary(std::istream& in, vector<Rational>& values);
+
+void BinaryFormat::write_header(std::ostream& out, uint16_t kind, uint64_t count) {
+	Header header = {{MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3]}, VERSION, kind, count};
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+uint64_t BinaryFormat::read_header(std::istream& in, uint16_t kind) {
+	Header header;
+	if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+		throw std::runtime_error("not a binary number stream");
+	}
+	if (header.version != VERSION || header.kind != kind) {
+		throw std::runtime_error("unsupported binary number stream");
+	}
+	return header.count;
+}
+void BinaryFormat::write_record(std::ostream& out, const BigInteger& x) {
+	Record record = {static_cast<uint32_t>(x.numbers.size()), x.sign ? 0 : NEGATIVE};
+	out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	out.write(reinterpret_cast<const char*>(x.numbers.data()), x.numbers.size() * sizeof(uint32_t));
+}
+void BinaryFormat::read_record(std::istream& in, BigInteger& x) {
+	Record record;
+	if (!in.read(reinterpret_cast<char*>(&record), sizeof(record)) || record.length == 0 || record.flags > NEGATIVE) {
+		throw std::runtime_error("corrupt binary number record");
+	}
+	x.numbers.clear();
+	for (size_t done = 0; done < record.length;) {
+		size_t chunk = min<size_t>(record.length - done, READ_CHUNK_LIMBS);
+		x.numbers.resize(done + chunk);
+		if (!in.read(reinterpret_cast<char*>(x.numbers.data() + done), chunk * sizeof(uint32_t))) {
+			throw std::runtime_error("truncated binary number record");
 		}
+		done += chunk;
+	}
+	if (!valid_limbs(x.numbers.data(), record.length)) {
+		throw std::runtime_error("corrupt binary number record");
 	}
-	if (numerator < 0) {
-		result += '-';
+	x.sign = !(record.flags & NEGATIVE);
+	x.norm();
+}
+bool BinaryFormat::valid_limbs(const uint32_t* limbs, size_t length) {
+	uint32_t largest = 0;
+	for (size_t i = 0; i < length; ++i) {
+		largest = max(largest, limbs[i]);
 	}
-	for (size_t i = 0; i < result.size() / 2; ++i) {
-		swap(result[i], result[result.size() - i - 1]);
+	return largest < BigInteger::BASE;
+}
+BigInteger BinaryFormat::from_limbs(const uint32_t* limbs, size_t length, bool negative) {
+	BigInteger result = BigInteger::from_limbs(limbs, limbs + length);
+	result.sign = !negative;
+	result.norm();
+	return result;
+}
+Rational BinaryFormat::from_parts(BigInteger numerator, BigInteger denominator) {
+	if (denominator <= 0) {
+		throw std::runtime_error("corrupt rational denominator");
 	}
+	// Nothing guarantees the stored parts are coprime, so they go through
+	// the same normalization as an arithmetic result.
+	Rational result;
+	result.numerator = std::move(numerator);
+	result.denominator = std::move(denominator);
+	result.is_small = false;
+	result.update();
 	return result;
 }
 
-Rational::operator double() {
-	string numbers = asDecimal(16);
-	for (size_t i = 0; i < numbers.size() / 2; ++i) {
-		swap(numbers[i], numbers[numbers.size() - i - 1]);
+BigIntegerView::BigIntegerView(const uint32_t* limbs, size_t length, bool negative) : limbs(limbs), length(length), is_negative(negative) {}
+size_t BigIntegerView::size() const {
+	return length;
+}
+bool BigIntegerView::negative() const {
+	return is_negative;
+}
+const uint32_t* BigIntegerView::data() const {
+	return limbs;
+}
+BigInteger BigIntegerView::toBigInteger() const {
+	return BinaryFormat::from_limbs(limbs, length, is_negative);
+}
+Rational RationalView::toRational() const {
+	return BinaryFormat::from_parts(numerator.toBigInteger(), denominator.toBigInteger());
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// Maps the whole file read-only and indexes the records; limbs are never
+// copied until a view is converted.
+MappedNumbers::MappedNumbers(const string& path) {
+	int descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		throw std::runtime_error("cannot open " + path);
 	}
-	double result = 0;
-	size_t power = 1;
-	size_t i = 0;
-	while (numbers[++i] != '.') {
-		result += power * static_cast<short>(numbers[i - 1]) - 48;
-		power *= 10;
+	struct stat info;
+	if (fstat(descriptor, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(BinaryFormat::Header)) {
+		close(descriptor);
+		throw std::runtime_error("not a binary number file: " + path);
 	}
-	power = 1;
-	for (size_t j = i; j < 16 + i; ++j) {
-		power /= 10;
-		result += power * (static_cast<short>(numbers[j]) - 48);
+	length = info.st_size;
+	void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	if (mapping == MAP_FAILED) {
+		throw std::runtime_error("cannot map " + path);
 	}
-	return result;
+	address = static_cast<const char*>(mapping);
+
+	const BinaryFormat::Header* header = reinterpret_cast<const BinaryFormat::Header*>(address);
+	if (memcmp(header->magic, BinaryFormat::MAGIC, sizeof(BinaryFormat::MAGIC)) != 0) fail("not a binary number file");
+	if (header->version != BinaryFormat::VERSION || header->kind > BinaryFormat::RATIONALS) fail("unsupported binary number file");
+	rationals = header->kind == BinaryFormat::RATIONALS;
+	if (header->count > length) fail("truncated binary number file");
+	uint64_t count = header->count * (rationals ? 2 : 1);
+	if (count > (length - sizeof(BinaryFormat::Header)) / sizeof(BinaryFormat::Record)) fail("truncated binary number file");
+	records.reserve(count);
+	size_t position = sizeof(BinaryFormat::Header);
+	for (uint64_t i = 0; i < count; ++i) {
+		if (length - position < sizeof(BinaryFormat::Record)) fail("truncated binary number file");
+		const BinaryFormat::Record* record = reinterpret_cast<const BinaryFormat::Record*>(address + position);
+		position += sizeof(BinaryFormat::Record);
+		if (record->length == 0 || record->flags > BinaryFormat::NEGATIVE) fail("corrupt binary number record");
+		if ((length - position) / sizeof(uint32_t) < record->length) fail("truncated binary number file");
+		if (!BinaryFormat::valid_limbs(reinterpret_cast<const uint32_t*>(record + 1), record->length)) fail("corrupt binary number record");
+		records.push_back(record);
+		position += record->length * sizeof(uint32_t);
+	}
+}
+MappedNumbers::~MappedNumbers() {
+	munmap(const_cast<char*>(address), length);
 }
+void MappedNumbers::fail(const char* message) {
+	munmap(const_cast<char*>(address), length);
+	throw std::runtime_error(message);
+}
+size_t MappedNumbers::size() const {
+	return rationals ? records.size() / 2 : records.size();
+}
+bool MappedNumbers::holdsRationals() const {
+	return rationals;
+}
+BigIntegerView MappedNumbers::view(size_t record) const {
+	const BinaryFormat::Record* header = records[record];
+	return BigIntegerView(reinterpret_cast<const uint32_t*>(header + 1), header->length, header->flags & BinaryFormat::NEGATIVE);
+}
+BigIntegerView MappedNumbers::operator[](size_t index) const {
+	return view(index);
+}
+RationalView MappedNumbers::rational(size_t index) const {
+	return RationalView{view(2 * index), view(2 * index + 1)};
+}
+#endif
 
-std::ostream& operator<<(std::ostream& out, const Rational& x) {
-	out << x.toString();
-	return out;
+void writeBinary(std::ostream& out, const vector<BigInteger>& values) {
+	BinaryFormat::write_header(out, BinaryFormat::INTEGERS, values.size());
+	for (const BigInteger& x : values) {
+		BinaryFormat::write_record(out, x);
+	}
+}
+void writeBinary(std::ostream& out, const vector<Rational>& values) {
+	BinaryFormat::write_header(out, BinaryFormat::RATIONALS, values.size());
+	for (const Rational& x : values) {
+		x.observe();
+		Rational::Wide value(x);
+		BinaryFormat::write_record(out, value.numerator);
+		BinaryFormat::write_record(out, value.denominator);
+	}
+}
+void readBinary(std::istream& in, vector<BigInteger>& values) {
+	uint64_t count = BinaryFormat::read_header(in, BinaryFormat::INTEGERS);
+	values.clear();
+	for (uint64_t i = 0; i < count; ++i) {
+		values.emplace_back();
+		BinaryFormat::read_record(in, values.back());
+	}
+}
+void readBinary(std::istream& in, vector<Rational>& values) {
+	uint64_t count = BinaryFormat::read_header(in, BinaryFormat::RATIONALS);
+	values.clear();
+	BigInteger numerator, denominator;
+	for (uint64_t i = 0; i < count; ++i) {
+		BinaryFormat::read_record(in, numerator);
+		BinaryFormat::read_record(in, denominator);
+		values.push_back(BinaryFormat::from_parts(std::move(numerator), std::move(denominator)));
+	}
 }
@@ -1,144 +1,177 @@
 #pragma once
 #include <iostream>
 #include <cstring>
+#include <algorithm>
 
 
 class String {
 public:
-	String() = default;
+	String() {
+		set_local_size(0);
+	}
 
 	String(const char* s) {
-		sz = strlen(s);
-		upt_capacity();
-		str = new char[capacity];
-		memcpy(str, s, sz);
+		init(strlen(s));
+		memcpy(buffer(), s, length());
 	}
 
 	String(size_t sz, char c) {
-		this->sz = sz;
-		upt_capacity();
-		str = new char[capacity];
-		memset(str, c, sz);
+		init(sz);
+		memset(buffer(), c, sz);
 	}
 
 	String(const char s) {
-		sz = 1;
-		upt_capacity();
-		str = new char[capacity];
-		*str = s;
+		init(1);
+		*buffer() = s;
 	}
 
 	String(const String& s) {
-		sz = s.sz;
-		upt_capacity();
-		str = new char[capacity];
-		memcpy(str, s.str, sz);
+		init(s.length());
+		memcpy(buffer(), s.buffer(), length());
+	}
+
+	String(String&& s) noexcept {
+		memcpy(local, s.local, sizeof(local));
+		s.set_local_size(0);
+	}
+
+	String& operator=(const String& s) {
+		if (this == &s) return *this;
+		if (s.length() > capacity()) {
+			String copy = s;
+			swap(copy);
+			return *this;
+		}
+		memcpy(buffer(), s.buffer(), s.length());
+		set_size(s.length());
+		return *this;
 	}
 
-	String& operator=(String s) {
+	String& operator=(String&& s) noexcept {
 		swap(s);
 		return *this;
 	}
 
 	~String() {
-		delete[] str;
+		if (!is_local()) delete[] heap.data;
 	}
 
 	size_t length() const {
-		return sz;
+		return is_local() ? LOCAL_CAPACITY - local[LOCAL_CAPACITY] : heap.size;
 	}
 
 	bool empty() const {
-		return sz == 0;
+		return length() == 0;
 	}
 
 	const char& front() const {
-		return str[0];
+		return buffer()[0];
 	}
 
 	const char& back() const {
-		return str[sz - 1];
+		return buffer()[length() - 1];
 	}
 
 	char& front() {
-		return str[0];
+		return buffer()[0];
 	}
 
 	char& back() {
-		return str[sz - 1];
+		return buffer()[length() - 1];
 	}
 
 	void push_back(char p) {
-		if (sz == 0) {
-			sz = 1;
-			str = new char[capacity];
-			str[0] = p;
-		}
-		else {
-			str[sz] = p;
-			++sz;
-			if (sz == capacity) {
-				capacity *= 2;
-				char* temporary = new char[capacity];
-				memcpy(temporary, str, sz);
-				char* old = str;
-				str = temporary;
+		size_t sz = length();
+		if (sz == capacity()) reallocate(2 * capacity());
+		buffer()[sz] = p;
+		set_size(sz + 1);
+	}
+	void pop_back() {
+		size_t sz = length() - 1;
+		set_size(sz);
+		if (!is_local() && sz <= capacity() / 4) {
+			if (sz <= LOCAL_CAPACITY) {
+				char* old = heap.data;
+				memcpy(local, old, sz);
+				set_local_size(sz);
 				delete[] old;
 			}
+			else {
+				reallocate(capacity() / 2);
+			}
 		}
 	}
-	void pop_back() {
-		--sz;
-		if (sz <= capacity / 4) {
-			capacity /= 2;
-			char* temporary = new char[capacity];
-			memcpy(temporary, str, sz);
-			char* old = str;
-			str = temporary;
+	void clear() {
+		if (!is_local()) delete[] heap.data;
+		set_local_size(0);
+	}
+	void reserve(size_t count) {
+		if (count > capacity()) reallocate(count);
+	}
+	void shrink_to_fit() {
+		if (is_local()) return;
+		size_t sz = length();
+		if (sz <= LOCAL_CAPACITY) {
+			char* old = heap.data;
+			memcpy(local, old, sz);
+			set_local_size(sz);
 			delete[] old;
 		}
+		else if (sz < capacity()) {
+			reallocate(sz);
+		}
 	}
-	void clear() {
-		sz = 0;
-		capacity = 2;
-		delete[] str;
-		str = new char[capacity];
-	}
-	String& operator+=(const String& s) {
-		for (size_t i = 0; i < s.sz; ++i) {
-			this->push_back(s[i]);
+	String& append(const char* s, size_t count) {
+		size_t sz = length();
+		if (sz + count > capacity()) {
+			// s may point into this string, so the old buffer outlives the copy.
+			size_t capacity = std::max(sz + count, 2 * this->capacity());
+			char* temporary = new char[capacity];
+			memcpy(temporary, buffer(), sz);
+			memcpy(temporary + sz, s, count);
+			if (!is_local()) delete[] heap.data;
+			heap.data = temporary;
+			heap.capacity = capacity | HEAP_FLAG;
+		}
+		else {
+			memmove(buffer() + sz, s, count);
 		}
+		set_size(sz + count);
 		return *this;
 	}
+	String& operator+=(const String& s) {
+		return append(s.buffer(), s.length());
+	}
 	friend bool operator==(const String& a, const String& b) {
-		return strcmp(a.str, b.str) == 0;
+		return a.length() == b.length() && memcmp(a.buffer(), b.buffer(), a.length()) == 0;
 	}
 	char& operator[](size_t index) {
-		return str[index];
+		return buffer()[index];
 	}
 
 	const char& operator[](size_t index) const {
-		return str[index];
+		return buffer()[index];
 	}
 	String substr(size_t start, size_t count) const {
 		String substr;
-		for (size_t i = start; i < start + count; ++i) {
-			substr.push_back(str[i]);
-		}
+		substr.reserve(count);
+		substr.append(buffer() + start, count);
 		return substr;
 	}
 
 	size_t find(const String& sub) const {
+		size_t sz = length();
 		for (size_t i = 0; i < sz - sub.length() + 1; ++i) {
-			if (memcmp(str + i, sub.str, sub.length()) == 0) {
+			if (memcmp(buffer() + i, sub.buffer(), sub.length()) == 0) {
 				return i;
 			}
 		}
 		return sz;
 	}
 	size_t rfind(const String& sub) const {
+		size_t sz = length();
 		for (int i = sz - sub.length(); i >= 0; --i) {
-			if (memcmp(str + i, sub.str, sub.length()) == 0) {
+			if (memcmp(buffer() + i, sub.buffer(), sub.length()) == 0) {
 				return i;
 			}
 		}
@@ -146,20 +179,76 @@ public:
 	}
 
 private:
-	size_t sz = 0;
-	size_t capacity = 2;
-	char* str = nullptr;
-	void upt_capacity() {
+	// Strings of up to LOCAL_CAPACITY chars live in the object itself. The
+	// last byte then holds the unused local capacity, so a full local string
+	// ends in '\0'; on the heap the same byte is the top of `capacity`,
+	// whose HEAP_FLAG bit tells the two apart (this assumes little-endian).
+	struct Heap {
+		char* data;
+		size_t size;
+		size_t capacity;
+	};
+	static constexpr size_t LOCAL_CAPACITY = sizeof(Heap) - 1;
+	static constexpr size_t HEAP_FLAG = size_t(1) << (8 * sizeof(size_t) - 1);
+#ifdef __BYTE_ORDER__
+	static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "String keeps its heap flag in the last byte");
+#endif
+
+	union {
+		Heap heap;
+		char local[LOCAL_CAPACITY + 1];
+	};
+
+	bool is_local() const {
+		return !(static_cast<unsigned char>(local[LOCAL_CAPACITY]) & 0x80);
+	}
+	size_t capacity() const {
+		return is_local() ? LOCAL_CAPACITY : heap.capacity & ~HEAP_FLAG;
+	}
+	char* buffer() {
+		return is_local() ? local : heap.data;
+	}
+	const char* buffer() const {
+		return is_local() ? local : heap.data;
+	}
+	void set_local_size(size_t sz) {
+		local[LOCAL_CAPACITY] = static_cast<char>(LOCAL_CAPACITY - sz);
+	}
+	void set_size(size_t sz) {
+		if (is_local()) set_local_size(sz);
+		else heap.size = sz;
+	}
+	void init(size_t sz) {
+		if (sz <= LOCAL_CAPACITY) {
+			set_local_size(sz);
+			return;
+		}
+		size_t capacity = upt_capacity(sz);
+		heap.data = new char[capacity];
+		heap.size = sz;
+		heap.capacity = capacity | HEAP_FLAG;
+	}
+	void reallocate(size_t capacity) {
+		size_t sz = length();
+		char* temporary = new char[capacity];
+		memcpy(temporary, buffer(), sz);
+		if (!is_local()) delete[] heap.data;
+		heap.data = temporary;
+		heap.size = sz;
+		heap.capacity = capacity | HEAP_FLAG;
+	}
+	static size_t upt_capacity(size_t sz) {
 		size_t tmp = 4;
 		while (tmp <= sz) {
 			tmp *= 2;
 		}
-		capacity = tmp * 2;
+		return tmp * 2;
 	}
 	void swap(String& s) {
-		std::swap(sz, s.sz);
-		std::swap(capacity, s.capacity);
-		std::swap(str, s.str);
+		char temporary[sizeof(local)];
+		memcpy(temporary, local, sizeof(local));
+		memcpy(local, s.local, sizeof(local));
+		memcpy(s.local, temporary, sizeof(local));
 	}
 };
 
@@ -184,7 +273,9 @@ std::istream& operator>>(std::istream& in, String& str) {
 }
 
 String operator+(const String& a, const String& b) {
-	String copy = a;
-	copy += b;
-	return copy;
+	String result;
+	result.reserve(a.length() + b.length());
+	result += a;
+	result += b;
+	return result;
 }